@@ -30,7 +30,10 @@
 
 #include "sl_audio_player.h"
 
+#include <sched.h>
+
 #include <ltlib/logging.h>
+#include <ltlib/threads.h>
 
 // 吐槽：SLES的接口也太微软了吧😱
 
@@ -153,6 +156,21 @@ bool SLAudioPlayer::play(const void* _data, uint32_t size) {
 
 void SLAudioPlayer::slCallback(SLAndroidSimpleBufferQueueItf bq, void* context) {
     auto that = reinterpret_cast<SLAudioPlayer*>(context);
+    if (!that->thread_options_applied_) {
+        // 回调线程是OpenSL自己的，可能已经是实时策略，只在普通策略下提高nice，不改调度策略.
+        // -16即THREAD_PRIORITY_AUDIO
+        that->thread_options_applied_ = true;
+        const int policy = sched_getscheduler(0);
+        if (policy == SCHED_OTHER) {
+            ltlib::ThreadOptions options;
+            options.priority = -16;
+            ltlib::apply_thread_options(options);
+        }
+        else {
+            LOG(INFO) << "OpenSL callback thread runs with policy " << policy
+                      << ", keep its priority";
+        }
+    }
     that->doPlay();
 }
 
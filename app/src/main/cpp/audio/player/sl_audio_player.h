@@ -62,6 +62,8 @@ private:
     std::deque<std::vector<uint8_t>> buffer_;
     std::mutex mutex_;
     std::vector<uint8_t> dummy_audio_;
+    // 只在回调线程访问
+    bool thread_options_applied_ = false;
 
 };
 
@@ -0,0 +1,109 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <thread>
+#include <vector>
+
+#include <graphics/decoder/fake_video_decoder.h>
+#include <graphics/decoder/video_decoder.h>
+
+#include "benchmark.h"
+
+namespace {
+
+// 经过注册表创建VaType::Fake的解码器，和VDRPipeline创建解码器的路径一样
+std::unique_ptr<lt::VideoDecoder> createFakeDecoder(bool async,
+                                                    const lt::FakeVideoDecoder::FakeParams& fake) {
+    lt::VideoDecoder::registerBackend(lt::VaType::Fake,
+                                      [fake](const lt::VideoDecoder::Params& params) {
+                                          return lt::FakeVideoDecoder::create(params, fake);
+                                      });
+    lt::VideoDecoder::Params params{};
+    params.codec_type = lt::VideoCodecType::H264;
+    params.width = 1920;
+    params.height = 1080;
+    params.va_type = lt::VaType::Fake;
+    params.async = async;
+    return lt::VideoDecoder::create(params);
+}
+
+// 每次迭代解出一帧，延迟是帧在解码器里的时间
+void asyncDecode(lt::bench::State& state, const lt::FakeVideoDecoder::FakeParams& fake) {
+    state.pauseTiming();
+    auto decoder = createFakeDecoder(true, fake);
+    const std::vector<uint8_t> frame(64 * 1024, 0);
+    state.resumeTiming();
+    uint64_t decoded = 0;
+    int64_t ltframe_id = 0;
+    while (decoded < state.iterations()) {
+        auto status =
+            decoder->submitFrame(frame.data(), static_cast<uint32_t>(frame.size()), ltframe_id);
+        if (status == lt::DecodeStatus::Success2) {
+            ltframe_id++;
+        }
+        while (auto decoded_frame = decoder->pollFrame()) {
+            decoded++;
+            if (decoded_frame->ltframe_id >= 0) {
+                state.recordLatency(decoded_frame->decode_time_us * 1000);
+            }
+        }
+        if (status == lt::DecodeStatus::EAgain) {
+            std::this_thread::sleep_for(std::chrono::microseconds{100});
+        }
+    }
+    state.pauseTiming();
+    state.setCounter("submitted_per_decoded",
+                     static_cast<double>(ltframe_id) / static_cast<double>(decoded));
+    decoder.reset();
+    state.resumeTiming();
+}
+
+} // namespace
+
+// 同步接口本身的开销
+LT_BENCHMARK(FakeDecoder_Sync_Decode) {
+    state.pauseTiming();
+    auto decoder = createFakeDecoder(false, lt::FakeVideoDecoder::FakeParams{0, 0, 0.0, 1});
+    const std::vector<uint8_t> frame(64 * 1024, 0);
+    state.resumeTiming();
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        auto decoded = decoder->decode(frame.data(), static_cast<uint32_t>(frame.size()));
+        lt::bench::doNotOptimize(decoded);
+    }
+}
+
+// 单帧5ms的解码器，同步模式最多200fps，异步模式多帧在途能到kMaxFramesInFlight倍
+LT_BENCHMARK_WITH_OPTIONS(FakeDecoder_Async_5ms, (lt::bench::Options{0.5, 2'000})) {
+    asyncDecode(state, lt::FakeVideoDecoder::FakeParams{5'000, 0, 0.0, 1});
+}
+
+LT_BENCHMARK_WITH_OPTIONS(FakeDecoder_Async_5msJitter2ms, (lt::bench::Options{0.5, 2'000})) {
+    asyncDecode(state, lt::FakeVideoDecoder::FakeParams{5'000, 2'000, 0.0, 1});
+}
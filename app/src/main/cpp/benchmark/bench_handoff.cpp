@@ -0,0 +1,148 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <ltlib/event_count.h>
+#include <ltlib/spsc_queue.h>
+
+#include "benchmark.h"
+
+// 对比VDRPipeline把编码帧交给解码线程的两种做法: 生产者打上时间戳入队，
+// 消费者取出时记录耗时. 生产者每隔kIntervalNs送一个，消费者大部分时间在睡眠，和真实场景一样.
+
+namespace {
+
+using lt::bench::nowNs;
+using namespace std::chrono_literals;
+
+constexpr int64_t kIntervalNs = 100'000;
+
+// 原来的做法: vector + mutex + condition_variable，消费者最多睡5ms
+class MutexChannel {
+public:
+    void push(int64_t value) {
+        {
+            std::lock_guard lock{mutex_};
+            items_.push_back(value);
+            signal_ = true;
+        }
+        cv_.notify_one();
+    }
+    void popAll(std::vector<int64_t>& out) {
+        out.clear();
+        std::unique_lock lock{mutex_};
+        if (items_.empty()) {
+            cv_.wait_for(lock, 5ms, [this]() { return signal_; });
+            signal_ = false;
+        }
+        out.swap(items_);
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool signal_ = false;
+    std::vector<int64_t> items_;
+};
+
+// 现在的做法: SpscQueue + EventCount
+class SpscChannel {
+public:
+    void push(int64_t value) {
+        while (!queue_.try_push(std::move(value))) {
+            std::this_thread::yield();
+        }
+        event_.notify();
+    }
+    void popAll(std::vector<int64_t>& out) {
+        out.clear();
+        auto key = event_.prepare_wait();
+        if (!queue_.empty()) {
+            event_.cancel_wait();
+        }
+        else {
+            event_.wait_for(key, 5ms);
+        }
+        int64_t value = 0;
+        while (queue_.try_pop(value)) {
+            out.push_back(value);
+        }
+    }
+
+private:
+    ltlib::SpscQueue<int64_t> queue_{64};
+    ltlib::EventCount event_;
+};
+
+template <typename Channel> void handoffLatency(lt::bench::State& state) {
+    Channel channel;
+    std::atomic<bool> stop{false};
+    std::vector<int64_t> latencies;
+    latencies.reserve(state.iterations());
+    std::thread consumer{[&]() {
+        std::vector<int64_t> items;
+        while (!stop.load(std::memory_order_acquire)) {
+            channel.popAll(items);
+            const int64_t now = nowNs();
+            for (int64_t sent_at : items) {
+                latencies.push_back(now - sent_at);
+            }
+        }
+    }};
+    // 用sleep而不是忙等控制节奏，单核机器上忙等会饿死消费者
+    auto next = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        std::this_thread::sleep_until(next);
+        channel.push(nowNs());
+        next += std::chrono::nanoseconds{kIntervalNs};
+    }
+    stop.store(true, std::memory_order_release);
+    channel.push(nowNs());
+    consumer.join();
+    for (int64_t latency : latencies) {
+        state.recordLatency(latency);
+    }
+}
+
+} // namespace
+
+LT_BENCHMARK_WITH_OPTIONS(Handoff_MutexCondvar, (lt::bench::Options{0.5, 5'000})) {
+    handoffLatency<MutexChannel>(state);
+}
+
+LT_BENCHMARK_WITH_OPTIONS(Handoff_SpscEventCount, (lt::bench::Options{0.5, 5'000})) {
+    handoffLatency<SpscChannel>(state);
+}
@@ -0,0 +1,88 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cinttypes>
+
+#include <ltlib/logging.h>
+
+#include "benchmark.h"
+
+// 异步日志在调用线程上的开销. 输出到/dev/null，不占控制台.
+// 用INFO级别，release下DEBUG在编译期就被去掉了
+namespace {
+
+class AsyncLogScope {
+public:
+    AsyncLogScope() {
+        ltlib::AsyncLogOptions options;
+        options.console = false;
+        options.file_path = "/dev/null";
+        options.buffer_size = 1024 * 1024;
+        ltlib::enableLogLevel(INFO);
+        ltlib::start_async_logging(options);
+    }
+    ~AsyncLogScope() {
+        ltlib::stop_async_logging();
+        ltlib::disableLogLevel(INFO);
+    }
+};
+
+} // namespace
+
+LT_BENCHMARK(AsyncLog_LOGF) {
+    state.pauseTiming();
+    AsyncLogScope scope;
+    state.resumeTiming();
+    const int64_t capture = 1'700'000'000'000'000;
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        LOGF(INFO, "capture:%" PRId64 ", start_enc:%" PRId64 ", end_enc:%" PRId64 ", id:%" PRIu64,
+             capture, capture + 1000, capture + 5000, i);
+        if ((i & 1023) == 1023) {
+            // 让后台线程跟上，测的是稳态开销而不是丢弃的开销
+            state.pauseTiming();
+            ltlib::flush_logs();
+            state.resumeTiming();
+        }
+    }
+}
+
+LT_BENCHMARK(AsyncLog_LOG) {
+    state.pauseTiming();
+    AsyncLogScope scope;
+    state.resumeTiming();
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        LOG(INFO) << "decoded frame " << i << " in " << 3000 << "us";
+        if ((i & 1023) == 1023) {
+            state.pauseTiming();
+            ltlib::flush_logs();
+            state.resumeTiming();
+        }
+    }
+}
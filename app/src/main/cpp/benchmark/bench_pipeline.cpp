@@ -0,0 +1,138 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+#include <thread>
+
+#include <ltlib/time_sync.h>
+#include <ltlib/times.h>
+
+#include <graphics/drpipeline/ct_smoother.h>
+#include <graphics/drpipeline/video_statistics.h>
+
+#include "benchmark.h"
+
+namespace {
+
+// 一帧在解码、渲染线程上产生的全部统计调用
+void updateOneFrame(lt::VideoStatistics& statistics, uint64_t i) {
+    statistics.addEncode();
+    statistics.updateVideoBW(50'000);
+    statistics.updateNetDelay(10'000 + static_cast<int64_t>(i % 5000));
+    statistics.updateDecodeTime(3'000 + static_cast<int64_t>(i % 2000));
+    statistics.addRenderVideo();
+    statistics.updateRenderVideoTime(500 + static_cast<int64_t>(i % 300));
+    statistics.addPresent();
+    statistics.updatePresentTime(1'000 + static_cast<int64_t>(i % 700));
+}
+
+void smootherPushTake(lt::bench::State& state, lt::CTSmoother::Mode mode) {
+    lt::CTSmoother smoother{mode};
+    constexpr int64_t kFrameIntervalUs = 16'667;
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        const int64_t capture = static_cast<int64_t>(i) * kFrameIntervalUs;
+        // 模拟0~3ms的网络抖动
+        const int64_t arrive = capture + 20'000 + static_cast<int64_t>((i * 7919) % 3000);
+        smoother.push(lt::CTSmoother::Frame{static_cast<int64_t>(i), static_cast<int64_t>(i),
+                                            arrive, capture});
+        auto frame = smoother.take(arrive + kFrameIntervalUs);
+        lt::bench::doNotOptimize(frame);
+    }
+}
+
+} // namespace
+
+LT_BENCHMARK(VideoStatistics_UpdateFrame) {
+    lt::VideoStatistics statistics;
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        updateOneFrame(statistics, i);
+    }
+}
+
+// 解码线程和渲染线程同时更新，统计线程每毫秒读一次
+LT_BENCHMARK(VideoStatistics_UpdateFrameContended) {
+    lt::VideoStatistics statistics;
+    std::atomic<bool> stop{false};
+    std::thread reader{[&]() {
+        while (!stop.load(std::memory_order_relaxed)) {
+            auto stat = statistics.getStat();
+            lt::bench::doNotOptimize(stat);
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+    }};
+    std::thread render{[&]() {
+        for (uint64_t i = 0; i < state.iterations(); i++) {
+            statistics.addRenderVideo();
+            statistics.updateRenderVideoTime(500 + static_cast<int64_t>(i % 300));
+            statistics.addPresent();
+            statistics.updatePresentTime(1'000 + static_cast<int64_t>(i % 700));
+        }
+    }};
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        statistics.addEncode();
+        statistics.updateVideoBW(50'000);
+        statistics.updateNetDelay(10'000 + static_cast<int64_t>(i % 5000));
+        statistics.updateDecodeTime(3'000 + static_cast<int64_t>(i % 2000));
+    }
+    render.join();
+    stop.store(true, std::memory_order_relaxed);
+    reader.join();
+}
+
+LT_BENCHMARK(VideoStatistics_GetStat) {
+    state.pauseTiming();
+    lt::VideoStatistics statistics;
+    for (uint64_t i = 0; i < 10'000; i++) {
+        updateOneFrame(statistics, i);
+    }
+    state.resumeTiming();
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        auto stat = statistics.getStat();
+        lt::bench::doNotOptimize(stat);
+    }
+}
+
+LT_BENCHMARK(CTSmoother_PushTake_LowLatency) {
+    smootherPushTake(state, lt::CTSmoother::Mode::LowLatency);
+}
+
+LT_BENCHMARK(CTSmoother_PushTake_Smooth) {
+    smootherPushTake(state, lt::CTSmoother::Mode::Smooth);
+}
+
+LT_BENCHMARK(TimeSync_Calc) {
+    ltlib::TimeSync time_sync;
+    int64_t t = ltlib::steady_now_us();
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        auto result = time_sync.calc(time_sync.getT0(), time_sync.getT1(), t + 10, t + 25);
+        lt::bench::doNotOptimize(result);
+        t += 1'000;
+    }
+}
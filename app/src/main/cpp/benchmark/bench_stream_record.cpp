@@ -0,0 +1,96 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <graphics/drpipeline/stream_recorder.h>
+#include <graphics/drpipeline/stream_replayer.h>
+
+#include "benchmark.h"
+
+namespace {
+
+constexpr uint32_t kClipFrames = 240;
+constexpr uint32_t kFrameSize = 32 * 1024;
+constexpr int64_t kFrameIntervalUs = 16'667;
+
+// 录一段4秒60fps的假视频流，一共7.5MB，不会超过StreamRecorder的积压上限
+std::string recordClip() {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "ltbench_stream.lrec").string();
+    auto recorder = lt::StreamRecorder::create(path, lt::VideoCodecType::H264, 1920, 1080);
+    if (recorder == nullptr) {
+        return "";
+    }
+    const std::vector<uint8_t> data(kFrameSize, 0);
+    for (uint32_t i = 0; i < kClipFrames; i++) {
+        lt::VideoFrame frame{};
+        frame.is_keyframe = i % 60 == 0;
+        frame.ltframe_id = i;
+        frame.data = data.data();
+        frame.size = kFrameSize;
+        frame.width = 1920;
+        frame.height = 1080;
+        frame.capture_timestamp_us = i * kFrameIntervalUs;
+        frame.start_encode_timestamp_us = frame.capture_timestamp_us + 1'000;
+        frame.end_encode_timestamp_us = frame.capture_timestamp_us + 5'000;
+        recorder->record(frame, frame.capture_timestamp_us + 20'000, 0);
+    }
+    // 析构时写完剩下的帧和索引
+    return path;
+}
+
+} // namespace
+
+// 每次迭代打开录制文件并尽快回放整段，是离线复现问题时读文件部分的开销
+LT_BENCHMARK_WITH_OPTIONS(StreamReplayer_MaxSpeed, (lt::bench::Options{0.5, 1'000})) {
+    state.pauseTiming();
+    const std::string path = recordClip();
+    state.resumeTiming();
+    uint64_t frames = 0;
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        auto replayer = lt::StreamReplayer::open(path);
+        if (replayer == nullptr) {
+            break;
+        }
+        auto stat = replayer->replay(lt::StreamReplayer::Pacing::MaxSpeed,
+                                     [](const lt::VideoFrame& frame, int64_t) {
+                                         lt::bench::doNotOptimize(frame.data);
+                                     });
+        frames += stat.frames;
+    }
+    state.pauseTiming();
+    state.setCounter("frames_per_iteration",
+                     static_cast<double>(frames) / static_cast<double>(state.iterations()));
+    std::filesystem::remove(path);
+    state.resumeTiming();
+}
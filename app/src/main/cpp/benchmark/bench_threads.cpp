@@ -0,0 +1,272 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ltlib/threads.h>
+#include <ltlib/times.h>
+
+#include "benchmark.h"
+
+namespace {
+
+using lt::bench::nowNs;
+
+// 等另一个线程把flag置为非0，返回它的值
+int64_t spinWait(const std::atomic<int64_t>& flag) {
+    int64_t value = 0;
+    while ((value = flag.load(std::memory_order_acquire)) == 0) {
+        std::this_thread::yield();
+    }
+    return value;
+}
+
+void reportAliveContended(lt::bench::State& state, size_t thread_count) {
+    state.pauseTiming();
+    auto watcher = ltlib::ThreadWatcher::instance();
+    std::vector<ltlib::ThreadWatcher::SlotID> slots;
+    for (size_t i = 0; i < thread_count; i++) {
+        slots.push_back(
+            watcher->add("bench_watch_" + std::to_string(i), std::this_thread::get_id()));
+    }
+    const uint64_t per_thread = state.iterations() / thread_count + 1;
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; i++) {
+        threads.emplace_back([&, i]() {
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (uint64_t n = 0; n < per_thread; n++) {
+                watcher->reportAlive(slots[i], static_cast<int64_t>(n));
+            }
+        });
+    }
+    state.resumeTiming();
+    go.store(true, std::memory_order_release);
+    for (auto& th : threads) {
+        th.join();
+    }
+    state.pauseTiming();
+    for (auto slot : slots) {
+        watcher->remove(slot);
+    }
+    state.resumeTiming();
+}
+
+} // namespace
+
+// 投递吞吐: 一个线程连续post，直到最后一个任务执行完
+LT_BENCHMARK(TaskThread_Post) {
+    state.pauseTiming();
+    auto thread = ltlib::TaskThread::create("bench_post");
+    const uint64_t n = state.iterations();
+    std::atomic<uint64_t> executed{0};
+    std::promise<void> done;
+    auto future = done.get_future();
+    state.resumeTiming();
+    for (uint64_t i = 0; i < n; i++) {
+        thread->post([&]() {
+            if (executed.fetch_add(1, std::memory_order_relaxed) + 1 == n) {
+                done.set_value();
+            }
+        });
+    }
+    future.wait();
+    state.pauseTiming();
+    thread.reset();
+    state.resumeTiming();
+}
+
+// 投递到空闲线程的延迟: post到任务开始执行，主要是唤醒的开销
+LT_BENCHMARK_WITH_OPTIONS(TaskThread_PostLatency, (lt::bench::Options{0.5, 20'000})) {
+    state.pauseTiming();
+    auto thread = ltlib::TaskThread::create("bench_post_latency");
+    state.resumeTiming();
+    std::atomic<int64_t> ran_at{0};
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        ran_at.store(0, std::memory_order_relaxed);
+        const int64_t start = nowNs();
+        thread->post([&ran_at]() { ran_at.store(nowNs(), std::memory_order_release); });
+        state.recordLatency(spinWait(ran_at) - start);
+    }
+    state.pauseTiming();
+    thread.reset();
+    state.resumeTiming();
+}
+
+// 定时任务的插入开销. 都排在1~2秒之后，测完直接销毁线程，不会执行
+LT_BENCHMARK_WITH_OPTIONS(TaskThread_PostDelay, (lt::bench::Options{0.5, 1'000'000})) {
+    state.pauseTiming();
+    auto thread = ltlib::TaskThread::create("bench_post_delay");
+    state.resumeTiming();
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        thread->post_delay(ltlib::TimeDelta{1'000'000 + static_cast<int64_t>(i % 1000) * 1000},
+                           []() {});
+    }
+    state.pauseTiming();
+    thread.reset();
+    state.resumeTiming();
+}
+
+// 定时精度: 1ms的定时任务实际晚了多久执行
+LT_BENCHMARK_WITH_OPTIONS(TaskThread_PostDelayLateness, (lt::bench::Options{0.5, 300})) {
+    state.pauseTiming();
+    auto thread = ltlib::TaskThread::create("bench_delay_lateness");
+    state.resumeTiming();
+    constexpr int64_t kDelayUs = 1'000;
+    std::atomic<int64_t> ran_at{0};
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        ran_at.store(0, std::memory_order_relaxed);
+        const int64_t start = nowNs();
+        thread->post_delay(ltlib::TimeDelta{kDelayUs},
+                           [&ran_at]() { ran_at.store(nowNs(), std::memory_order_release); });
+        state.recordLatency(spinWait(ran_at) - start - kDelayUs * 1000);
+    }
+    state.pauseTiming();
+    thread.reset();
+    state.resumeTiming();
+}
+
+LT_BENCHMARK(ThreadWatcher_ReportAlive_1Thread) {
+    reportAliveContended(state, 1);
+}
+
+LT_BENCHMARK(ThreadWatcher_ReportAlive_4Threads) {
+    reportAliveContended(state, 4);
+}
+
+// 同TaskThread_Post，换成挂在线程池上的Strand
+LT_BENCHMARK(Strand_Post) {
+    state.pauseTiming();
+    auto executor = ltlib::Executor::create("bench_exec", 0);
+    auto strand = ltlib::Strand::create(executor.get(), "bench_post");
+    const uint64_t n = state.iterations();
+    std::atomic<uint64_t> executed{0};
+    std::promise<void> done;
+    auto future = done.get_future();
+    state.resumeTiming();
+    for (uint64_t i = 0; i < n; i++) {
+        strand->post([&]() {
+            if (executed.fetch_add(1, std::memory_order_relaxed) + 1 == n) {
+                done.set_value();
+            }
+        });
+    }
+    future.wait();
+    state.pauseTiming();
+    strand.reset();
+    executor.reset();
+    state.resumeTiming();
+}
+
+LT_BENCHMARK_WITH_OPTIONS(Strand_PostLatency, (lt::bench::Options{0.5, 20'000})) {
+    state.pauseTiming();
+    auto executor = ltlib::Executor::create("bench_exec", 0);
+    auto strand = ltlib::Strand::create(executor.get(), "bench_post_latency");
+    state.resumeTiming();
+    std::atomic<int64_t> ran_at{0};
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        ran_at.store(0, std::memory_order_relaxed);
+        const int64_t start = nowNs();
+        strand->post([&ran_at]() { ran_at.store(nowNs(), std::memory_order_release); });
+        state.recordLatency(spinWait(ran_at) - start);
+    }
+    state.pauseTiming();
+    strand.reset();
+    executor.reset();
+    state.resumeTiming();
+}
+
+LT_BENCHMARK_WITH_OPTIONS(Strand_PostDelayLateness, (lt::bench::Options{0.5, 300})) {
+    state.pauseTiming();
+    auto executor = ltlib::Executor::create("bench_exec", 0);
+    auto strand = ltlib::Strand::create(executor.get(), "bench_delay_lateness");
+    state.resumeTiming();
+    constexpr int64_t kDelayUs = 1'000;
+    std::atomic<int64_t> ran_at{0};
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        ran_at.store(0, std::memory_order_relaxed);
+        const int64_t start = nowNs();
+        strand->post_delay(ltlib::TimeDelta{kDelayUs},
+                           [&ran_at]() { ran_at.store(nowNs(), std::memory_order_release); });
+        state.recordLatency(spinWait(ran_at) - start - kDelayUs * 1000);
+    }
+    state.pauseTiming();
+    strand.reset();
+    executor.reset();
+    state.resumeTiming();
+}
+
+// 4个线程同时往各自的Strand投递，看偷任务和多生产者下的吞吐
+LT_BENCHMARK(Strand_Post_4Strands) {
+    state.pauseTiming();
+    auto executor = ltlib::Executor::create("bench_exec", 0);
+    constexpr size_t kStrands = 4;
+    std::vector<std::unique_ptr<ltlib::Strand>> strands;
+    for (size_t i = 0; i < kStrands; i++) {
+        strands.push_back(ltlib::Strand::create(executor.get(), "bench_strand"));
+    }
+    const uint64_t per_strand = state.iterations() / kStrands + 1;
+    std::atomic<uint64_t> executed{0};
+    std::promise<void> done;
+    auto future = done.get_future();
+    std::atomic<bool> go{false};
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < kStrands; i++) {
+        producers.emplace_back([&, i]() {
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (uint64_t n = 0; n < per_strand; n++) {
+                strands[i]->post([&]() {
+                    if (executed.fetch_add(1, std::memory_order_relaxed) + 1 ==
+                        per_strand * kStrands) {
+                        done.set_value();
+                    }
+                });
+            }
+        });
+    }
+    state.resumeTiming();
+    go.store(true, std::memory_order_release);
+    for (auto& th : producers) {
+        th.join();
+    }
+    future.wait();
+    state.pauseTiming();
+    strands.clear();
+    executor.reset();
+    state.resumeTiming();
+}
@@ -0,0 +1,156 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <ltlib/threads.h>
+#include <ltlib/timing_wheel.h>
+
+#include "benchmark.h"
+
+namespace {
+
+constexpr size_t kPendingTimers = 10'000;
+constexpr int64_t kStartUs = 1'000'000'000;
+
+// 定时间隔分布在1ms~10s，和keepalive、统计、超时检查差不多
+std::vector<int64_t> makeDelays(size_t count) {
+    std::vector<int64_t> delays(count);
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (auto& delay : delays) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        delay = 1'000 + static_cast<int64_t>((seed >> 33) % 10'000'000);
+    }
+    return delays;
+}
+
+const std::vector<int64_t>& delays() {
+    static const std::vector<int64_t> kDelays = makeDelays(kPendingTimers * 4);
+    return kDelays;
+}
+
+// 原先TaskThread的做法: 以到期时间为key，冲突时往后挪1us
+class MapTimers {
+public:
+    int64_t add(int64_t when, std::function<void()> task) {
+        while (timers_.find(when) != timers_.end()) {
+            when++;
+        }
+        timers_.emplace(when, std::move(task));
+        return when;
+    }
+    void cancel(int64_t id) { timers_.erase(id); }
+
+private:
+    std::map<int64_t, std::function<void()>> timers_;
+};
+
+} // namespace
+
+// 已有1万个定时器时插入再取消一个
+LT_BENCHMARK(TimingWheel_AddCancel_10kPending) {
+    state.pauseTiming();
+    ltlib::TimingWheel wheel{kStartUs};
+    const auto& d = delays();
+    for (size_t i = 0; i < kPendingTimers; i++) {
+        wheel.add(kStartUs + d[i], []() {});
+    }
+    state.resumeTiming();
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        auto id = wheel.add(kStartUs + d[i % d.size()], []() {});
+        wheel.cancel(id);
+    }
+}
+
+// 对照组: 原来std::map的实现
+LT_BENCHMARK(StdMap_AddCancel_10kPending) {
+    state.pauseTiming();
+    MapTimers timers;
+    const auto& d = delays();
+    for (size_t i = 0; i < kPendingTimers; i++) {
+        timers.add(kStartUs + d[i], []() {});
+    }
+    state.resumeTiming();
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        auto id = timers.add(kStartUs + d[i % d.size()], []() {});
+        timers.cancel(id);
+    }
+}
+
+// 稳态: 时间每次前进1ms，到期的定时器执行后马上重新投递自己，始终保持1万个
+LT_BENCHMARK(TimingWheel_Tick_10kPending) {
+    state.pauseTiming();
+    ltlib::TimingWheel wheel{kStartUs};
+    const auto& d = delays();
+    size_t next_delay = 0;
+    int64_t now = kStartUs;
+    uint64_t fired = 0;
+    std::function<void()> repost = [&]() {
+        fired++;
+        wheel.add(now + d[next_delay++ % d.size()], repost);
+    };
+    for (size_t i = 0; i < kPendingTimers; i++) {
+        wheel.add(now + d[next_delay++ % d.size()], repost);
+    }
+    std::vector<ltlib::TimingWheel::Expired> expired;
+    state.resumeTiming();
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        now += ltlib::TimingWheel::kTickUs;
+        expired.clear();
+        wheel.advance(now, expired);
+        for (auto& timer : expired) {
+            timer.task();
+        }
+    }
+    state.setCounter("fired_per_tick", static_cast<double>(fired) / state.iterations());
+}
+
+// 通过TaskThread的接口，包含加锁和唤醒
+LT_BENCHMARK(TaskThread_PostDelayCancel_10kPending) {
+    state.pauseTiming();
+    auto thread = ltlib::TaskThread::create("bench_delay_cancel");
+    const auto& d = delays();
+    for (size_t i = 0; i < kPendingTimers; i++) {
+        // 排在1000秒之后，测试期间不会到期
+        thread->post_delay(ltlib::TimeDelta{1'000'000'000 + d[i]}, []() {});
+    }
+    state.resumeTiming();
+    for (uint64_t i = 0; i < state.iterations(); i++) {
+        auto id = thread->post_delay(ltlib::TimeDelta{1'000'000'000 + d[i % d.size()]}, []() {});
+        thread->cancel(id);
+    }
+    state.pauseTiming();
+    thread.reset();
+    state.resumeTiming();
+}
@@ -0,0 +1,209 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+void writeJsonString(std::ostream& out, const std::string& str) {
+    out << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) >= 0x20) {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+namespace lt {
+
+namespace bench {
+
+State::State(uint64_t iterations)
+    : iterations_{iterations} {}
+
+void State::pauseTiming() {
+    paused_at_ns_ = nowNs();
+}
+
+void State::resumeTiming() {
+    paused_ns_ += nowNs() - paused_at_ns_;
+    paused_at_ns_ = 0;
+}
+
+void State::recordLatency(int64_t ns) {
+    if (latency_ == nullptr) {
+        latency_ = std::make_unique<ltlib::Histogram>();
+    }
+    latency_->record(ns);
+}
+
+void State::setCounter(const std::string& name, double value) {
+    counters_[name] = value;
+}
+
+Runner& Runner::instance() {
+    static Runner runner;
+    return runner;
+}
+
+void Runner::add(const std::string& name, const Function& func, const Options& options) {
+    benchmarks_.push_back(Benchmark{name, func, options});
+}
+
+std::vector<Result> Runner::run(const std::string& filter, double min_time_s) {
+    std::vector<Result> results;
+    for (const auto& benchmark : benchmarks_) {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        results.push_back(runOne(benchmark, min_time_s));
+        std::fprintf(stderr, "%s done\n", benchmark.name.c_str());
+    }
+    return results;
+}
+
+Result Runner::runOne(const Benchmark& benchmark, double min_time_s) {
+    min_time_s = std::min(min_time_s, benchmark.options.min_time_s);
+    const int64_t min_time_ns = static_cast<int64_t>(min_time_s * 1e9);
+    uint64_t iterations = 1;
+    for (;;) {
+        State state{iterations};
+        state.start_ns_ = nowNs();
+        benchmark.func(state);
+        const int64_t elapsed_ns = std::max<int64_t>(nowNs() - state.start_ns_ - state.paused_ns_, 1);
+        if (elapsed_ns >= min_time_ns || iterations >= benchmark.options.max_iterations) {
+            Result result;
+            result.name = benchmark.name;
+            result.iterations = iterations;
+            result.ns_per_op = static_cast<double>(elapsed_ns) / iterations;
+            result.ops_per_sec = 1e9 / result.ns_per_op;
+            if (state.latency_ != nullptr) {
+                result.latency_count = state.latency_->count();
+                result.latency_p50_ns = state.latency_->percentile(50);
+                result.latency_p90_ns = state.latency_->percentile(90);
+                result.latency_p99_ns = state.latency_->percentile(99);
+                result.latency_p999_ns = state.latency_->percentile(99.9);
+                result.latency_max_ns = state.latency_->max();
+            }
+            result.counters = std::move(state.counters_);
+            return result;
+        }
+        // 按这次的速度估算够min_time的次数，多给一些余量，但一次最多放大100倍
+        const double scale = 1.4 * min_time_ns / elapsed_ns;
+        uint64_t next = static_cast<uint64_t>(iterations * std::min(scale, 100.0));
+        iterations = std::min(std::max(next, iterations + 1), benchmark.options.max_iterations);
+    }
+}
+
+std::string toTable(const std::vector<Result>& results) {
+    std::ostringstream oss;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-40s %12s %12s %10s %10s %10s\n", "benchmark",
+                  "iterations", "ns/op", "p50(ns)", "p99(ns)", "max(ns)");
+    oss << line;
+    for (const auto& r : results) {
+        if (r.latency_count != 0) {
+            std::snprintf(line, sizeof(line), "%-40s %12llu %12.1f %10lld %10lld %10lld\n",
+                          r.name.c_str(), static_cast<unsigned long long>(r.iterations),
+                          r.ns_per_op, static_cast<long long>(r.latency_p50_ns),
+                          static_cast<long long>(r.latency_p99_ns),
+                          static_cast<long long>(r.latency_max_ns));
+        }
+        else {
+            std::snprintf(line, sizeof(line), "%-40s %12llu %12.1f %10s %10s %10s\n",
+                          r.name.c_str(), static_cast<unsigned long long>(r.iterations),
+                          r.ns_per_op, "-", "-", "-");
+        }
+        oss << line;
+        for (const auto& counter : r.counters) {
+            std::snprintf(line, sizeof(line), "    %-36s %.3f\n", counter.first.c_str(),
+                          counter.second);
+            oss << line;
+        }
+    }
+    return oss.str();
+}
+
+std::string toJson(const std::vector<Result>& results) {
+    std::ostringstream oss;
+    oss << "{\"context\":{\"cpus\":" << std::thread::hardware_concurrency()
+#if defined(NDEBUG)
+        << ",\"build\":\"release\""
+#else
+        << ",\"build\":\"debug\""
+#endif
+        << "},\"benchmarks\":[";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        oss << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+        writeJsonString(oss, r.name);
+        oss << ",\"iterations\":" << r.iterations << ",\"ns_per_op\":" << r.ns_per_op
+            << ",\"ops_per_sec\":" << r.ops_per_sec;
+        if (r.latency_count != 0) {
+            oss << ",\"latency_ns\":{\"count\":" << r.latency_count
+                << ",\"p50\":" << r.latency_p50_ns << ",\"p90\":" << r.latency_p90_ns
+                << ",\"p99\":" << r.latency_p99_ns << ",\"p999\":" << r.latency_p999_ns
+                << ",\"max\":" << r.latency_max_ns << "}";
+        }
+        if (!r.counters.empty()) {
+            oss << ",\"counters\":{";
+            bool first = true;
+            for (const auto& counter : r.counters) {
+                oss << (first ? "" : ",");
+                writeJsonString(oss, counter.first);
+                oss << ":" << counter.second;
+                first = false;
+            }
+            oss << "}";
+        }
+        oss << "}";
+    }
+    oss << "\n]}\n";
+    return oss.str();
+}
+
+Registrar::Registrar(const char* name, const Function& func, const Options& options) {
+    Runner::instance().add(name, func, options);
+}
+
+} // namespace bench
+
+} // namespace lt
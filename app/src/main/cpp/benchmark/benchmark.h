@@ -0,0 +1,141 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ltlib/histogram.h>
+
+namespace lt {
+
+namespace bench {
+
+inline int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 一次运行的上下文. 被测函数执行iterations()次操作，计时由框架负责，
+// 准备工作放在pauseTiming()/resumeTiming()之间.
+class State {
+public:
+    explicit State(uint64_t iterations);
+    uint64_t iterations() const { return iterations_; }
+    void pauseTiming();
+    void resumeTiming();
+    // 单次操作的耗时(ns)，有数据时结果里带上分位
+    void recordLatency(int64_t ns);
+    // 其它需要输出的指标
+    void setCounter(const std::string& name, double value);
+
+private:
+    friend class Runner;
+    const uint64_t iterations_;
+    int64_t start_ns_ = 0;
+    int64_t paused_at_ns_ = 0;
+    int64_t paused_ns_ = 0;
+    std::unique_ptr<ltlib::Histogram> latency_;
+    std::map<std::string, double> counters_;
+};
+
+using Function = std::function<void(State&)>;
+
+struct Options {
+    // 单次运行至少这么久才认为结果稳定
+    double min_time_s = 0.5;
+    // 每次运行都很慢的用例(比如等定时器)用这个限制次数
+    uint64_t max_iterations = 1'000'000'000;
+};
+
+struct Result {
+    std::string name;
+    uint64_t iterations = 0;
+    double ns_per_op = 0;
+    double ops_per_sec = 0;
+    uint64_t latency_count = 0;
+    int64_t latency_p50_ns = 0;
+    int64_t latency_p90_ns = 0;
+    int64_t latency_p99_ns = 0;
+    int64_t latency_p999_ns = 0;
+    int64_t latency_max_ns = 0;
+    std::map<std::string, double> counters;
+};
+
+class Runner {
+public:
+    static Runner& instance();
+    void add(const std::string& name, const Function& func, const Options& options);
+    // filter为空时全部运行，否则只运行名字包含filter的用例
+    std::vector<Result> run(const std::string& filter, double min_time_s);
+
+private:
+    struct Benchmark {
+        std::string name;
+        Function func;
+        Options options;
+    };
+    Result runOne(const Benchmark& benchmark, double min_time_s);
+
+private:
+    std::vector<Benchmark> benchmarks_;
+};
+
+std::string toTable(const std::vector<Result>& results);
+std::string toJson(const std::vector<Result>& results);
+
+struct Registrar {
+    Registrar(const char* name, const Function& func, const Options& options = {});
+};
+
+// 用法:
+//     LT_BENCHMARK(Foo_Bar) { for (uint64_t i = 0; i < state.iterations(); i++) { ... } }
+#define LT_BENCHMARK_WITH_OPTIONS(name, options)                                                   \
+    static void name(lt::bench::State& state);                                                     \
+    static const lt::bench::Registrar name##_registrar{#name, name, options};                      \
+    static void name(lt::bench::State& state)
+
+#define LT_BENCHMARK(name) LT_BENCHMARK_WITH_OPTIONS(name, lt::bench::Options{})
+
+// 防止编译器把被测代码优化掉
+template <typename T> inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace bench
+
+} // namespace lt
@@ -0,0 +1,107 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <ltlib/logging.h>
+
+#include "benchmark.h"
+
+namespace {
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s [--filter=<substring>] [--format=table|json] [--out=<file>] "
+                 "[--min-time=<seconds>]\n",
+                 program);
+}
+
+bool startsWith(const char* str, const char* prefix, const char** value) {
+    size_t len = std::strlen(prefix);
+    if (std::strncmp(str, prefix, len) != 0) {
+        return false;
+    }
+    *value = str + len;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    std::string format = "table";
+    std::string out_path;
+    double min_time_s = 0.5;
+    for (int i = 1; i < argc; i++) {
+        const char* value = nullptr;
+        if (startsWith(argv[i], "--filter=", &value)) {
+            filter = value;
+        }
+        else if (startsWith(argv[i], "--format=", &value)) {
+            format = value;
+        }
+        else if (startsWith(argv[i], "--out=", &value)) {
+            out_path = value;
+        }
+        else if (startsWith(argv[i], "--min-time=", &value)) {
+            min_time_s = std::atof(value);
+        }
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if ((format != "table" && format != "json") || min_time_s <= 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    // 被测代码里的日志会干扰计时
+    ltlib::disableLogLevel(DEBUG);
+    ltlib::disableLogLevel(INFO);
+    auto results = lt::bench::Runner::instance().run(filter, min_time_s);
+    std::string output =
+        format == "json" ? lt::bench::toJson(results) : lt::bench::toTable(results);
+    if (out_path.empty()) {
+        std::fputs(output.c_str(), stdout);
+        return 0;
+    }
+    std::ofstream out{out_path, std::ios::out | std::ios::trunc};
+    out << output;
+    out.close();
+    if (!out) {
+        std::fprintf(stderr, "write %s failed\n", out_path.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// 用FakeAsyncCodec驱动AsyncVideoDecoder，检查解码器丢帧、输入缓冲区出错时不会卡死.
+// 失败时打印原因并返回非0
+
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <ltlib/logging.h>
+#include <ltlib/times.h>
+
+#include <graphics/decoder/async_video_decoder.h>
+#include <graphics/decoder/fake_async_codec.h>
+
+namespace {
+
+#define CHECK_TRUE(cond)                                                                           \
+    do {                                                                                           \
+        if (!(cond)) {                                                                             \
+            std::fprintf(stderr, "%s:%d check failed: %s\n", __FILE__, __LINE__, #cond);          \
+            return false;                                                                          \
+        }                                                                                          \
+    } while (false)
+
+lt::VideoDecoder::Params decoderParams() {
+    lt::VideoDecoder::Params params{};
+    params.codec_type = lt::VideoCodecType::H264;
+    params.width = 1920;
+    params.height = 1080;
+    params.va_type = lt::VaType::Fake;
+    params.async = true;
+    return params;
+}
+
+std::unique_ptr<lt::AsyncVideoDecoder> createDecoder(const lt::FakeAsyncCodec::Params& params) {
+    auto decoder = std::make_unique<lt::AsyncVideoDecoder>(
+        decoderParams(), std::make_unique<lt::FakeAsyncCodec>(params));
+    if (!decoder->init()) {
+        return nullptr;
+    }
+    return decoder;
+}
+
+// 解码器连续丢掉kMaxFramesInFlight帧后不会再有输出，在途的帧必须按时间过期
+bool testLossyCodecDoesNotStall() {
+    lt::FakeAsyncCodec::Params params{};
+    params.decode_latency_us = 1'000;
+    params.failure_rate = 0.5;
+    params.seed = 7;
+    auto decoder = createDecoder(params);
+    CHECK_TRUE(decoder != nullptr);
+
+    constexpr int64_t kFrames = 100;
+    const std::vector<uint8_t> frame(1024, 0);
+    const int64_t deadline = ltlib::steady_now_us() + 20'000'000;
+    int64_t submitted = 0;
+    int64_t outputs = 0;
+    while (submitted < kFrames && ltlib::steady_now_us() < deadline) {
+        auto status = decoder->submitFrame(frame.data(), static_cast<uint32_t>(frame.size()),
+                                           submitted);
+        CHECK_TRUE(status != lt::DecodeStatus::Failed);
+        if (status == lt::DecodeStatus::Success2) {
+            submitted++;
+        }
+        while (auto decoded = decoder->pollFrame()) {
+            CHECK_TRUE(decoded->status == lt::DecodeStatus::Success2);
+            outputs++;
+        }
+        if (status == lt::DecodeStatus::EAgain) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+    }
+    std::printf("lossy codec: submitted=%lld outputs=%lld in_flight=%u\n",
+                static_cast<long long>(submitted), static_cast<long long>(outputs),
+                decoder->framesInFlight());
+    CHECK_TRUE(submitted == kFrames);
+    CHECK_TRUE(outputs > 0);
+    return true;
+}
+
+// 放不下的帧不能占用输入缓冲区，之后的正常帧照样能送进去
+bool testOversizedFrameKeepsInputBuffer() {
+    lt::FakeAsyncCodec::Params params{};
+    params.decode_latency_us = 1'000;
+    params.num_input_buffers = 2;
+    params.input_buffer_size = 1024;
+    auto decoder = createDecoder(params);
+    CHECK_TRUE(decoder != nullptr);
+
+    const std::vector<uint8_t> large(2048, 0);
+    const std::vector<uint8_t> small(512, 0);
+    // 等输入缓冲区到位
+    const int64_t deadline = ltlib::steady_now_us() + 1'000'000;
+    lt::DecodeStatus status = lt::DecodeStatus::EAgain;
+    while (status == lt::DecodeStatus::EAgain && ltlib::steady_now_us() < deadline) {
+        status = decoder->submitFrame(large.data(), static_cast<uint32_t>(large.size()), 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    CHECK_TRUE(status == lt::DecodeStatus::Failed);
+    for (uint32_t i = 0; i < params.num_input_buffers * 4; i++) {
+        status = decoder->submitFrame(large.data(), static_cast<uint32_t>(large.size()), 0);
+        CHECK_TRUE(status == lt::DecodeStatus::Failed);
+    }
+    CHECK_TRUE(decoder->framesInFlight() == 0);
+    status = decoder->submitFrame(small.data(), static_cast<uint32_t>(small.size()), 1);
+    CHECK_TRUE(status == lt::DecodeStatus::Success2);
+    return true;
+}
+
+} // namespace
+
+int main() {
+    ltlib::disableLogLevel(INFO);
+    bool ok = true;
+    ok = testLossyCodecDoesNotStall() && ok;
+    ok = testOversizedFrameKeepsInputBuffer() && ok;
+    std::printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
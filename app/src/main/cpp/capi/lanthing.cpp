@@ -37,6 +37,7 @@
 #include <client/native_client.h>
 #include <ltlib/logging.h>
 #include <ltlib/threads.h>
+#include <ltlib/trace.h>
 
 JavaVM* g_jvm = nullptr;
 
@@ -54,6 +55,8 @@ lt::LtNativeClient* ncast(jlong ptr) {
 } // namespace
 
 extern "C" JNIEXPORT jint JNI_OnLoad(JavaVM* vm, void* reserved) {
+    // 解码、渲染线程上的日志只写线程本地缓冲区，由后台线程格式化后写logcat
+    ltlib::start_async_logging(ltlib::AsyncLogOptions{});
     LOG(INFO) << "JNI_OnLoad";
     (void)reserved;
     g_jvm = vm;
@@ -65,7 +68,8 @@ extern "C" JNIEXPORT jlong JNICALL Java_cn_lanthing_ltmsdk_LtClient_createNative
     jint videoWidth, jint videoHeight, jstring client_id,
     jstring room_id, jstring token, jstring p2p_username, jstring p2p_password,
     jstring signaling_address, jint signaling_port, jstring codec_type, jint audio_channels,
-    jint audio_freq, jobject reflex_servers) {
+    jint audio_freq, jobject reflex_servers, jboolean async_decode,
+    jboolean smooth_playback, jstring record_path) {
 
     LOG(INFO) << "createNativeClient JvmClient " << thiz;
     ltlib::ThreadWatcher::instance()->disableCrashOnTimeout();
@@ -98,6 +102,9 @@ extern "C" JNIEXPORT jlong JNICALL Java_cn_lanthing_ltmsdk_LtClient_createNative
     params.audio_channels = audio_channels;
     params.audio_freq = audio_freq;
     params.reflex_servers = rflxs;
+    params.async_decode = async_decode == JNI_TRUE;
+    params.smooth_playback = smooth_playback == JNI_TRUE;
+    params.record_path = jStr2Std(env, record_path);
     if (!params.validate()) {
         return 0;
     }
@@ -142,4 +149,26 @@ extern "C" JNIEXPORT void JNICALL Java_cn_lanthing_ltmsdk_LtClient_nativeOnSigna
     std::string real_value(jb, jb + size);
     env->ReleaseByteArrayElements(value, jb, 0);
     ncast(cli)->onSignalingMessage(jStr2Std(env, key), real_value);
-}
\ No newline at end of file
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_cn_lanthing_ltmsdk_LtClient_nativeReplayStream(
+    JNIEnv* env, jobject thiz, jlong cli, jstring path, jboolean max_speed) {
+    return ncast(cli)->replayStream(jStr2Std(env, path), max_speed == JNI_TRUE);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_cn_lanthing_ltmsdk_LtClient_nativeSetTracing(JNIEnv* env,
+                                                                                    jobject thiz,
+                                                                                    jboolean enable) {
+    if (enable) {
+        ltlib::Tracer::instance()->enable();
+    }
+    else {
+        ltlib::Tracer::instance()->disable();
+    }
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_cn_lanthing_ltmsdk_LtClient_nativeDumpTrace(JNIEnv* env,
+                                                                                      jobject thiz,
+                                                                                      jstring path) {
+    return ltlib::Tracer::instance()->dump(jStr2Std(env, path));
+}
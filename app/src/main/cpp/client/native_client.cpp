@@ -47,6 +47,7 @@
 #include <ltproto/signaling/signaling_message_ack.pb.h>
 
 #include <ltlib/logging.h>
+#include <ltlib/trace.h>
 #include <ltproto/ltproto.h>
 
 #include <rtc/rtc.h>
@@ -141,14 +142,22 @@ LtNativeClient::LtNativeClient(const Params& params)
                               std::placeholders::_2, std::placeholders::_3)}
     , audio_params_{AudioCodecType::PCM, static_cast<uint32_t>(params.audio_freq),
                     static_cast<uint32_t>(params.audio_channels)}
-    , reflex_servers_{params.reflex_servers} {}
+    , reflex_servers_{params.reflex_servers} {
+    video_params_.async_decode = params.async_decode;
+    video_params_.smooth_playback = params.smooth_playback;
+    video_params_.record_path = params.record_path;
+}
 
 LtNativeClient::~LtNativeClient() {
     // LtNativeClient和lanthing-pc的Client的线程模型是不一样的，析构要小心处理
+    // 回放线程在用video_pipeline_，要先停掉
+    stop_replay_ = true;
+    replay_thread_.reset();
 }
 
 bool LtNativeClient::start() {
-    thread_ = ltlib::TaskThread::create("native_client");
+    // 逻辑都是些短任务，不值得单独占一个线程，挂到共享线程池上串行执行
+    strand_ = ltlib::Strand::create(ltlib::Executor::shared(), "native_client");
     if (!initTransport()) {
         LOG(INFO) << "Initialize rtc failed";
         return false;
@@ -157,12 +166,13 @@ bool LtNativeClient::start() {
     return true;
 }
 
-void LtNativeClient::postTask(const std::function<void()>& task) {
-    thread_->post(task);
+void LtNativeClient::postTask(ltlib::Strand::Task task, const ltlib::Location& from) {
+    strand_->post(std::move(task), from);
 }
 
-void LtNativeClient::postDelayTask(int64_t delay_ms, const std::function<void()>& task) {
-    thread_->post_delay(ltlib::TimeDelta{delay_ms * 1000}, task);
+void LtNativeClient::postDelayTask(int64_t delay_ms, ltlib::Strand::Task task,
+                                   const ltlib::Location& from) {
+    strand_->post_delay(ltlib::TimeDelta{delay_ms * 1000}, std::move(task), from);
 }
 
 void LtNativeClient::checkWorkerTimeout() {
@@ -172,6 +182,8 @@ void LtNativeClient::checkWorkerTimeout() {
     if (now - last_received_keepalive_ > kFiveSeconds) {
         LOG(INFO) << "Didn't receive KeepAliveAck from worker for "
                   << (now - last_received_keepalive_) << "ms, exit";
+        // 可能是我们自己的任务堵住了，没来得及处理KeepAliveAck
+        LOG(INFO) << "Task metrics: " << strand_->metrics().collect().toString();
         tellAppKeepAliveTimeout();
         // 为了让消息发送到app，延迟50ms再关闭程序
         postDelayTask(50, [this]() { jvm_client_->onNativeClosed(); });
@@ -180,6 +192,12 @@ void LtNativeClient::checkWorkerTimeout() {
     postDelayTask(k500ms, std::bind(&LtNativeClient::checkWorkerTimeout, this));
 }
 
+void LtNativeClient::reportTaskMetrics() {
+    LOG(INFO) << "Task metrics: " << strand_->metrics().collect().toString();
+    constexpr int64_t k10s = 10'000;
+    postDelayTask(k10s, std::bind(&LtNativeClient::reportTaskMetrics, this));
+}
+
 void LtNativeClient::syncTime() {
     auto msg = std::make_shared<ltproto::client2service::TimeSync>();
     msg->set_t0(time_sync_.getT0());
@@ -198,6 +216,55 @@ void LtNativeClient::switchMouseMode() {
     sendMessageToHost(ltproto::id(msg), msg, true);
 }
 
+bool LtNativeClient::replayStream(const std::string& path, bool max_speed) {
+    std::lock_guard lock{dr_mutex_};
+    if (video_pipeline_ != nullptr || replay_thread_ != nullptr) {
+        LOG(ERR) << "Video pipeline already exists, can't replay stream";
+        return false;
+    }
+    replayer_ = StreamReplayer::open(path);
+    if (replayer_ == nullptr) {
+        return false;
+    }
+    VideoDecodeRenderPipeline::Params params = video_params_;
+    params.codec_type = replayer_->codec();
+    params.width = replayer_->width();
+    params.height = replayer_->height();
+    // 别把回放的帧又录一遍
+    params.record_path.clear();
+    video_pipeline_ = VideoDecodeRenderPipeline::create(params);
+    if (video_pipeline_ == nullptr) {
+        LOG(ERR) << "Create VideoDecodeRenderPipeline for replay failed";
+        return false;
+    }
+    const auto pacing = max_speed ? StreamReplayer::Pacing::MaxSpeed
+                                  : StreamReplayer::Pacing::Original;
+    replay_thread_ = ltlib::BlockingThread::create(
+        "stream_replayer", [this, pacing](const std::function<void()>& i_am_alive) {
+            replayLoop(pacing, i_am_alive);
+        });
+    return true;
+}
+
+void LtNativeClient::replayLoop(StreamReplayer::Pacing pacing,
+                                const std::function<void()>& i_am_alive) {
+    int64_t last_time_diff_us = 0;
+    replayer_->replay(
+        pacing,
+        [this, &i_am_alive, &last_time_diff_us](const lt::VideoFrame& frame,
+                                                int64_t time_diff_us) {
+            i_am_alive();
+            std::lock_guard lock{dr_mutex_};
+            if (time_diff_us != last_time_diff_us) {
+                last_time_diff_us = time_diff_us;
+                video_pipeline_->setTimeDiff(time_diff_us);
+            }
+            // 回放时没有对端可以请求关键帧，忽略返回值
+            video_pipeline_->submit(frame);
+        },
+        &stop_replay_);
+}
+
 void LtNativeClient::tellAppKeepAliveTimeout() {
     // FIXME: 具体通知是KeepAliveTimeout引起的断链
     jvm_client_->onNativeClosed();
@@ -267,6 +334,7 @@ void LtNativeClient::onTpData(void* user_data, const uint8_t* data, uint32_t siz
 }
 
 void LtNativeClient::onTpVideoFrame(void* user_data, const lt::VideoFrame& frame) {
+    LT_TRACE_SCOPE("on_video_frame");
     auto that = reinterpret_cast<LtNativeClient*>(user_data);
     std::lock_guard lock{that->dr_mutex_};
     if (that->video_pipeline_ == nullptr) {
@@ -309,7 +377,7 @@ void LtNativeClient::onTpConnected(void* user_data, lt::LinkType link_type) {
         return;
     }
     // 心跳检测
-    that->thread_->post(std::bind(&LtNativeClient::sendKeepAlive, that));
+    that->strand_->post(std::bind(&LtNativeClient::sendKeepAlive, that));
     that->last_received_keepalive_ = ltlib::steady_now_ms();
     that->postDelayTask(500, std::bind(&LtNativeClient::checkWorkerTimeout, that));
     // 如果未来有“串流”以外的业务，在这个StartTransmission添加字段.
@@ -318,6 +386,7 @@ void LtNativeClient::onTpConnected(void* user_data, lt::LinkType link_type) {
     start->set_token(that->auth_token_);
     that->sendMessageToHost(ltproto::id(start), start, true);
     that->postTask(std::bind(&LtNativeClient::syncTime, that));
+    that->postDelayTask(10'000, std::bind(&LtNativeClient::reportTaskMetrics, that));
 
     // setTitle
     that->is_p2p_ = link_type != lt::LinkType::RelayUDP;
@@ -359,6 +428,7 @@ void LtNativeClient::onTpSignalingMessage(void* user_data, const char* key, cons
 
 void LtNativeClient::dispatchRemoteMessage(
     uint32_t type, const std::shared_ptr<google::protobuf::MessageLite>& msg) {
+    LT_TRACE_SCOPE("dispatch_remote_message");
     switch (type) {
     case ltproto::type::kKeepAliveAck:
         onKeepAliveAck();
@@ -386,7 +456,7 @@ void LtNativeClient::sendKeepAlive() {
     sendMessageToHost(ltproto::id(keep_alive), keep_alive, true);
 
     const auto k500ms = ltlib::TimeDelta{500'000};
-    thread_->post_delay(k500ms, std::bind(&LtNativeClient::sendKeepAlive, this));
+    strand_->post_delay(k500ms, std::bind(&LtNativeClient::sendKeepAlive, this));
 }
 
 void LtNativeClient::onKeepAliveAck() {
@@ -429,6 +499,7 @@ void LtNativeClient::onTimeSync(std::shared_ptr<google::protobuf::MessageLite> _
         rtt_ = result->rtt;
         time_diff_ = result->time_diff;
         LOG(DEBUG) << "rtt:" << rtt_ << ", time_diff:" << time_diff_;
+        LT_TRACE_COUNTER("rtt_us", rtt_);
         if (video_pipeline_) {
             video_pipeline_->setTimeDiff(time_diff_);
             video_pipeline_->setRTT(rtt_);
@@ -447,14 +518,9 @@ void LtNativeClient::onCursorInfo(std::shared_ptr<google::protobuf::MessageLite>
     LOGF(DEBUG, "onCursorInfo id:%d, w:%d, h:%d, x:%d, y%d", msg->preset(), msg->w(), msg->h(),
          msg->x(), msg->y());
     if (msg->w() == 0 || msg->h() == 0) {
-        // 这个这么丑的flag，只是为了不让这行错误日志频繁打
-        if (!last_w_or_h_is_0_) {
-            last_w_or_h_is_0_ = true;
-            LOG(ERR) << "Received CursorInfo with w " << msg->w() << " h " << msg->h();
-        }
+        LOG_EVERY_T(ERR, 10) << "Received CursorInfo with w " << msg->w() << " h " << msg->h();
         return;
     }
-    last_w_or_h_is_0_ = false;
     video_pipeline_->setCursorInfo(msg->preset(), 1.0f * msg->x() / msg->w(),
                                    1.0f * msg->y() / msg->h(), msg->visible());
 }
@@ -34,6 +34,7 @@
 #include <vector>
 #include <optional>
 #include <memory>
+#include <atomic>
 
 #include <google/protobuf/message_lite.h>
 
@@ -42,6 +43,7 @@
 
 #include <audio/player/audio_player.h>
 #include <graphics/drpipeline/video_decode_render_pipeline.h>
+#include <graphics/drpipeline/stream_replayer.h>
 #include <client/jvm_client_proxy.h>
 
 namespace lt {
@@ -66,6 +68,10 @@ public:
         int32_t audio_channels;
         int32_t audio_freq;
         std::vector<std::string> reflex_servers;
+        // 见VideoDecodeRenderPipeline::Params
+        bool async_decode = false;
+        bool smooth_playback = false;
+        std::string record_path;
 
         bool validate() const;
     };
@@ -79,15 +85,22 @@ public:
     void onPlatformStop();
     void onSignalingMessage(const std::string& key, const std::string& value);
     void switchMouseMode();
+    // 调试用: 新建一个pipeline回放StreamRecorder的录制文件，代替网络收到的帧.
+    // 只在没有start()的client上调用
+    bool replayStream(const std::string& path, bool max_speed);
 
 private:
     LtNativeClient(const Params& params);
 
-    void postTask(const std::function<void()>& task);
-    void postDelayTask(int64_t delay_ms, const std::function<void()>& task);
+    void postTask(ltlib::Strand::Task task,
+                  const ltlib::Location& from = ltlib::Location::current());
+    void postDelayTask(int64_t delay_ms, ltlib::Strand::Task task,
+                       const ltlib::Location& from = ltlib::Location::current());
     void checkWorkerTimeout();
+    void reportTaskMetrics();
     void syncTime();
     void tellAppKeepAliveTimeout();
+    void replayLoop(StreamReplayer::Pacing pacing, const std::function<void()>& i_am_alive);
 
     // transport
     bool initTransport();
@@ -122,14 +135,16 @@ private:
     std::mutex dr_mutex_;
     std::unique_ptr<VideoDecodeRenderPipeline> video_pipeline_;
     std::unique_ptr<AudioPlayer> audio_player_;
+    std::unique_ptr<StreamReplayer> replayer_;
+    std::atomic<bool> stop_replay_{false};
+    std::unique_ptr<ltlib::BlockingThread> replay_thread_;
     lt::tp::Client* tp_client_ = nullptr;
-    std::unique_ptr<ltlib::TaskThread> thread_;
+    std::unique_ptr<ltlib::Strand> strand_;
     ltlib::TimeSync time_sync_;
     int64_t rtt_ = 0;
     int64_t time_diff_ = 0;
     std::optional<bool> is_p2p_;
     bool absolute_mouse_ = true;
-    bool last_w_or_h_is_0_ = false;
     int64_t last_received_keepalive_ = 0;
 };
 
@@ -0,0 +1,57 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace lt {
+
+// 异步解码器后端的最小抽象. 设备上由MediaCodec的异步模式实现，host上用FakeAsyncCodec代替.
+// 回调可能发生在任意线程
+class AsyncCodec {
+public:
+    struct Callbacks {
+        std::function<void(int32_t /*index*/)> on_input_available;
+        std::function<void(int32_t /*index*/, int64_t /*pts*/)> on_output_available;
+        std::function<void(int32_t /*error*/)> on_error;
+    };
+
+public:
+    virtual ~AsyncCodec() = default;
+    virtual bool start(const Callbacks& callbacks) = 0;
+    virtual void stop() = 0;
+    virtual uint8_t* inputBuffer(int32_t index, size_t* capacity) = 0;
+    virtual bool queueInput(int32_t index, uint32_t size, int64_t pts) = 0;
+    virtual bool releaseOutput(int32_t index, bool render) = 0;
+};
+
+} // namespace lt
@@ -0,0 +1,242 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "async_video_decoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <ltlib/logging.h>
+#include <ltlib/times.h>
+
+namespace lt {
+
+AsyncVideoDecoder::AsyncVideoDecoder(const Params& params, std::unique_ptr<AsyncCodec> codec)
+    : VideoDecoder(params)
+    , codec_{std::move(codec)} {}
+
+AsyncVideoDecoder::~AsyncVideoDecoder() {
+    if (codec_) {
+        codec_->stop();
+    }
+}
+
+bool AsyncVideoDecoder::init() {
+    AsyncCodec::Callbacks callbacks{};
+    callbacks.on_input_available = [this](int32_t index) { onInputAvailable(index); };
+    callbacks.on_output_available = [this](int32_t index, int64_t pts) {
+        onOutputAvailable(index, pts);
+    };
+    callbacks.on_error = [this](int32_t error) { onError(error); };
+    return codec_->start(callbacks);
+}
+
+DecodedFrame AsyncVideoDecoder::decode(const uint8_t* data, uint32_t size) {
+    // 兼容同步接口: 送入一帧，等它解出来
+    DecodedFrame frame{};
+    {
+        std::unique_lock lock{mutex_};
+        cv_.wait_for(lock, std::chrono::seconds{1},
+                     [this]() { return failed_ || !free_inputs_.empty(); });
+    }
+    frame.status = submitFrame(data, size, 0);
+    if (frame.status != DecodeStatus::Success2) {
+        return frame;
+    }
+    {
+        std::unique_lock lock{mutex_};
+        cv_.wait_for(lock, std::chrono::seconds{1},
+                     [this]() { return failed_ || !outputs_.empty(); });
+    }
+    auto decoded = pollFrame();
+    if (!decoded.has_value()) {
+        LOG(ERR) << "AsyncVideoDecoder wait for output timeout";
+        frame.status = DecodeStatus::Failed;
+        return frame;
+    }
+    return decoded.value();
+}
+
+std::vector<void*> AsyncVideoDecoder::textures() {
+    return {};
+}
+
+bool AsyncVideoDecoder::isAsync() const {
+    return true;
+}
+
+void AsyncVideoDecoder::setNotifier(const std::function<void()>& notifier) {
+    std::lock_guard lock{mutex_};
+    notifier_ = notifier;
+}
+
+DecodeStatus AsyncVideoDecoder::submitFrame(const uint8_t* data, uint32_t size,
+                                            int64_t ltframe_id) {
+    int32_t index = -1;
+    {
+        std::lock_guard lock{mutex_};
+        if (failed_) {
+            return DecodeStatus::Failed;
+        }
+        expireInFlight(ltlib::steady_now_us());
+        if (free_inputs_.empty() || in_flight_.size() >= kMaxFramesInFlight) {
+            return DecodeStatus::EAgain;
+        }
+        index = free_inputs_.front();
+        free_inputs_.pop_front();
+    }
+    size_t capacity = 0;
+    uint8_t* buff = codec_->inputBuffer(index, &capacity);
+    if (buff == nullptr) {
+        // 解码器不认这个index，不能再用
+        LOG(ERR) << "AsyncVideoDecoder get input buffer " << index << " failed";
+        return DecodeStatus::Failed;
+    }
+    if (capacity < size) {
+        LOGF(ERR, "AsyncVideoDecoder input buffer size(%zu) < input frame size(%u)", capacity,
+             size);
+        // 还没送进解码器，缓冲区仍归我们
+        std::lock_guard lock{mutex_};
+        free_inputs_.push_front(index);
+        return DecodeStatus::Failed;
+    }
+    ::memcpy(buff, data, size);
+    int64_t pts = 0;
+    {
+        // 必须在queueInput()之前登记，否则输出可能先于登记到达
+        std::lock_guard lock{mutex_};
+        // 用pts把输出对应回输入，必须严格递增
+        pts = std::max(ltlib::steady_now_us(), last_pts_ + 1);
+        last_pts_ = pts;
+        in_flight_.push_back({pts, ltframe_id, ltlib::steady_now_us(), renderOutput()});
+    }
+    if (!codec_->queueInput(index, size, pts)) {
+        LOG(ERR) << "AsyncVideoDecoder queue input " << index << " failed";
+        std::lock_guard lock{mutex_};
+        auto iter = std::find_if(in_flight_.begin(), in_flight_.end(),
+                                 [pts](const InFlight& f) { return f.pts == pts; });
+        if (iter != in_flight_.end()) {
+            in_flight_.erase(iter);
+        }
+        free_inputs_.push_front(index);
+        return DecodeStatus::Failed;
+    }
+    return DecodeStatus::Success2;
+}
+
+std::optional<DecodedFrame> AsyncVideoDecoder::pollFrame() {
+    Output output{};
+    DecodedFrame frame{};
+    {
+        std::lock_guard lock{mutex_};
+        if (failed_) {
+            frame.status = DecodeStatus::Failed;
+            return frame;
+        }
+        if (outputs_.empty()) {
+            return std::nullopt;
+        }
+        output = outputs_.front();
+        outputs_.pop_front();
+        frame.ltframe_id = -1;
+        // 解码器可能丢掉一些输入(比如参考帧缺失)，早于这个pts的都不会再有输出了
+        while (!in_flight_.empty() && in_flight_.front().pts <= output.pts) {
+            if (in_flight_.front().pts == output.pts) {
+                frame.ltframe_id = in_flight_.front().ltframe_id;
+                frame.decode_time_us = output.time_us - in_flight_.front().submit_time_us;
+                frame.render = in_flight_.front().render;
+            }
+            in_flight_.pop_front();
+        }
+    }
+    // 和同步模式一样，直接交给Surface显示
+    codec_->releaseOutput(output.index, frame.render);
+    frame.status = DecodeStatus::Success2;
+    frame.frame = 1;
+    return frame;
+}
+
+uint32_t AsyncVideoDecoder::framesInFlight() {
+    std::lock_guard lock{mutex_};
+    expireInFlight(ltlib::steady_now_us());
+    return static_cast<uint32_t>(in_flight_.size());
+}
+
+void AsyncVideoDecoder::expireInFlight(int64_t now_us) {
+    // 解码器丢帧时不会有任何通知，只能等后面的输出把它“挤”出去. 如果连续丢了
+    // kMaxFramesInFlight帧，就不会再有输出，不按时间清理的话后面的提交会一直EAgain
+    size_t expired = 0;
+    while (!in_flight_.empty() &&
+           now_us - in_flight_.front().submit_time_us >= kInFlightTimeoutUs) {
+        in_flight_.pop_front();
+        expired++;
+    }
+    if (expired != 0) {
+        LOG_EVERY_T(WARNING, 1) << "AsyncVideoDecoder " << expired << " frames got no output in "
+                                << kInFlightTimeoutUs / 1000 << "ms, treat as dropped";
+    }
+}
+
+void AsyncVideoDecoder::onInputAvailable(int32_t index) {
+    {
+        std::lock_guard lock{mutex_};
+        free_inputs_.push_back(index);
+    }
+    notify();
+}
+
+void AsyncVideoDecoder::onOutputAvailable(int32_t index, int64_t pts) {
+    {
+        std::lock_guard lock{mutex_};
+        outputs_.push_back({index, pts, ltlib::steady_now_us()});
+    }
+    notify();
+}
+
+void AsyncVideoDecoder::onError(int32_t error) {
+    LOG(ERR) << "AsyncVideoDecoder codec error " << error;
+    {
+        std::lock_guard lock{mutex_};
+        failed_ = true;
+    }
+    notify();
+}
+
+void AsyncVideoDecoder::notify() {
+    {
+        std::lock_guard lock{mutex_};
+        if (notifier_) {
+            notifier_();
+        }
+    }
+    cv_.notify_all();
+}
+
+} // namespace lt
@@ -0,0 +1,93 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <graphics/decoder/video_decoder.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include <graphics/decoder/async_codec.h>
+
+namespace lt {
+
+// 多帧同时在解码器里的异步解码. 输入和输出分开处理，输出通过pts对应回ltframe_id
+class AsyncVideoDecoder : public VideoDecoder {
+public:
+    // 同时在解码器里的帧数上限，再多只会增加延迟
+    static constexpr uint32_t kMaxFramesInFlight = 4;
+    // 送进去这么久还没有输出，认为被解码器丢掉了. 远大于正常的解码耗时
+    static constexpr int64_t kInFlightTimeoutUs = 500'000;
+
+public:
+    AsyncVideoDecoder(const Params& params, std::unique_ptr<AsyncCodec> codec);
+    ~AsyncVideoDecoder() override;
+
+    bool init();
+    DecodedFrame decode(const uint8_t* data, uint32_t size) override;
+    std::vector<void*> textures() override;
+    bool isAsync() const override;
+    void setNotifier(const std::function<void()>& notifier) override;
+    DecodeStatus submitFrame(const uint8_t* data, uint32_t size, int64_t ltframe_id) override;
+    std::optional<DecodedFrame> pollFrame() override;
+    uint32_t framesInFlight() override;
+
+private:
+    void onInputAvailable(int32_t index);
+    void onOutputAvailable(int32_t index, int64_t pts);
+    void onError(int32_t error);
+    void notify();
+    void expireInFlight(int64_t now_us);
+
+private:
+    struct InFlight {
+        int64_t pts;
+        int64_t ltframe_id;
+        int64_t submit_time_us;
+        bool render;
+    };
+    struct Output {
+        int32_t index;
+        int64_t pts;
+        int64_t time_us;
+    };
+    std::unique_ptr<AsyncCodec> codec_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::function<void()> notifier_;
+    std::deque<int32_t> free_inputs_;
+    std::deque<Output> outputs_;
+    std::deque<InFlight> in_flight_;
+    int64_t last_pts_ = 0;
+    bool failed_ = false;
+};
+
+} // namespace lt
@@ -0,0 +1,156 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "fake_async_codec.h"
+
+#include <ltlib/times.h>
+
+namespace lt {
+
+FakeAsyncCodec::FakeAsyncCodec(const Params& params)
+    : params_{params}
+    , input_buffers_(params.num_input_buffers)
+    , random_engine_{params.seed} {
+    for (auto& buffer : input_buffers_) {
+        buffer.resize(params_.input_buffer_size);
+    }
+}
+
+FakeAsyncCodec::~FakeAsyncCodec() {
+    stop();
+}
+
+bool FakeAsyncCodec::start(const Callbacks& callbacks) {
+    std::lock_guard lock{mutex_};
+    if (!stoped_) {
+        return false;
+    }
+    callbacks_ = callbacks;
+    stoped_ = false;
+    for (uint32_t i = 0; i < params_.num_input_buffers; i++) {
+        inputs_to_return_.push_back(static_cast<int32_t>(i));
+    }
+    for (uint32_t i = 0; i < params_.num_output_buffers; i++) {
+        free_outputs_.push_back(static_cast<int32_t>(i));
+    }
+    thread_ = std::thread{[this]() { workLoop(); }};
+    return true;
+}
+
+void FakeAsyncCodec::stop() {
+    {
+        std::lock_guard lock{mutex_};
+        stoped_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+uint8_t* FakeAsyncCodec::inputBuffer(int32_t index, size_t* capacity) {
+    if (index < 0 || static_cast<size_t>(index) >= input_buffers_.size()) {
+        return nullptr;
+    }
+    *capacity = input_buffers_[index].size();
+    return input_buffers_[index].data();
+}
+
+bool FakeAsyncCodec::queueInput(int32_t index, uint32_t size, int64_t pts) {
+    {
+        std::lock_guard lock{mutex_};
+        if (stoped_) {
+            return false;
+        }
+        // 跟MediaCodec一样，输入缓冲区被“消费”后马上归还，空帧不产生输出
+        inputs_to_return_.push_back(index);
+        int64_t latency = params_.decode_latency_us;
+        if (params_.decode_jitter_us > 0) {
+            std::uniform_int_distribution<int64_t> jitter{-params_.decode_jitter_us,
+                                                          params_.decode_jitter_us};
+            latency += jitter(random_engine_);
+        }
+        std::bernoulli_distribution fail{params_.failure_rate};
+        bool dropped = fail(random_engine_);
+        if (size != 0 && !dropped) {
+            pending_.push_back({ltlib::steady_now_us() + latency, pts});
+        }
+    }
+    cv_.notify_all();
+    return true;
+}
+
+bool FakeAsyncCodec::releaseOutput(int32_t index, bool render) {
+    (void)render;
+    {
+        std::lock_guard lock{mutex_};
+        free_outputs_.push_back(index);
+    }
+    cv_.notify_all();
+    return true;
+}
+
+void FakeAsyncCodec::workLoop() {
+    std::unique_lock lock{mutex_};
+    while (!stoped_) {
+        while (!inputs_to_return_.empty()) {
+            int32_t index = inputs_to_return_.front();
+            inputs_to_return_.pop_front();
+            lock.unlock();
+            callbacks_.on_input_available(index);
+            lock.lock();
+        }
+        int64_t now = ltlib::steady_now_us();
+        if (!pending_.empty() && !free_outputs_.empty() && pending_.front().ready_time_us <= now) {
+            Pending pending = pending_.front();
+            pending_.pop_front();
+            int32_t index = free_outputs_.front();
+            free_outputs_.pop_front();
+            lock.unlock();
+            callbacks_.on_output_available(index, pending.pts);
+            lock.lock();
+            continue;
+        }
+        auto has_work = [this]() {
+            return stoped_ || !inputs_to_return_.empty() ||
+                   (!pending_.empty() && !free_outputs_.empty() &&
+                    pending_.front().ready_time_us <= ltlib::steady_now_us());
+        };
+        if (!pending_.empty() && !free_outputs_.empty()) {
+            cv_.wait_for(lock, std::chrono::microseconds{pending_.front().ready_time_us - now},
+                         has_work);
+        }
+        else {
+            cv_.wait(lock, has_work);
+        }
+    }
+}
+
+} // namespace lt
@@ -0,0 +1,88 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <graphics/decoder/async_codec.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace lt {
+
+// host上用来代替MediaCodec的假解码器，不做真正的解码，每一帧在设定的延迟后“解出来”.
+// 让AsyncVideoDecoder可以脱离设备运行. 只在host上的benchmark和测试里编译，不进APK
+class FakeAsyncCodec : public AsyncCodec {
+public:
+    struct Params {
+        int64_t decode_latency_us = 5'000;
+        int64_t decode_jitter_us = 0;
+        // 解码器丢掉某一帧、不产生输出的概率
+        double failure_rate = 0.0;
+        uint32_t seed = 1;
+        uint32_t num_input_buffers = 8;
+        uint32_t num_output_buffers = 8;
+        uint32_t input_buffer_size = 4 * 1024 * 1024;
+    };
+
+public:
+    FakeAsyncCodec(const Params& params);
+    ~FakeAsyncCodec() override;
+    bool start(const Callbacks& callbacks) override;
+    void stop() override;
+    uint8_t* inputBuffer(int32_t index, size_t* capacity) override;
+    bool queueInput(int32_t index, uint32_t size, int64_t pts) override;
+    bool releaseOutput(int32_t index, bool render) override;
+
+private:
+    void workLoop();
+
+private:
+    struct Pending {
+        int64_t ready_time_us;
+        int64_t pts;
+    };
+    const Params params_;
+    Callbacks callbacks_;
+    std::vector<std::vector<uint8_t>> input_buffers_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<int32_t> inputs_to_return_;
+    std::deque<Pending> pending_;
+    std::deque<int32_t> free_outputs_;
+    std::mt19937 random_engine_;
+    bool stoped_ = true;
+    std::thread thread_;
+};
+
+} // namespace lt
@@ -0,0 +1,87 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "fake_video_decoder.h"
+
+#include <thread>
+
+#include "async_video_decoder.h"
+#include "fake_async_codec.h"
+
+namespace lt {
+
+std::unique_ptr<VideoDecoder> FakeVideoDecoder::create(const Params& params,
+                                                       const FakeParams& fake_params) {
+    if (params.async) {
+        FakeAsyncCodec::Params codec_params{};
+        codec_params.decode_latency_us = fake_params.decode_latency_us;
+        codec_params.decode_jitter_us = fake_params.decode_jitter_us;
+        codec_params.failure_rate = fake_params.failure_rate;
+        codec_params.seed = fake_params.seed;
+        std::unique_ptr<AsyncVideoDecoder> decoder{
+            new AsyncVideoDecoder(params, std::make_unique<FakeAsyncCodec>(codec_params))};
+        if (!decoder->init()) {
+            return nullptr;
+        }
+        return decoder;
+    }
+    return std::make_unique<FakeVideoDecoder>(params, fake_params);
+}
+
+FakeVideoDecoder::FakeVideoDecoder(const Params& params, const FakeParams& fake_params)
+    : VideoDecoder(params)
+    , fake_params_{fake_params}
+    , random_engine_{fake_params.seed} {}
+
+DecodedFrame FakeVideoDecoder::decode(const uint8_t* data, uint32_t size) {
+    (void)data;
+    (void)size;
+    int64_t latency = fake_params_.decode_latency_us;
+    if (fake_params_.decode_jitter_us > 0) {
+        std::uniform_int_distribution<int64_t> jitter{-fake_params_.decode_jitter_us,
+                                                      fake_params_.decode_jitter_us};
+        latency += jitter(random_engine_);
+    }
+    std::bernoulli_distribution fail{fake_params_.failure_rate};
+    bool failed = fail(random_engine_);
+    if (latency > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds{latency});
+    }
+    DecodedFrame frame{};
+    frame.status = failed ? DecodeStatus::Failed : DecodeStatus::Success2;
+    frame.frame = ++frame_no_;
+    return frame;
+}
+
+std::vector<void*> FakeVideoDecoder::textures() {
+    return {};
+}
+
+} // namespace lt
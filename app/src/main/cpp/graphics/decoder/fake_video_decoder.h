@@ -0,0 +1,67 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <graphics/decoder/video_decoder.h>
+
+#include <random>
+
+namespace lt {
+
+// 不做真正解码的假解码器，用于在没有GPU的机器上运行、压测解码器. 只在host上的benchmark
+// 里编译，不进APK，由使用者通过VideoDecoder::registerBackend()注册为VaType::Fake.
+// VDRPipeline还依赖JNI、protobuf和渲染器，目前整条管线仍不能在host上编译.
+// 同样的FakeParams(包括seed)总是产生同样的延迟和失败序列
+class FakeVideoDecoder : public VideoDecoder {
+public:
+    struct FakeParams {
+        int64_t decode_latency_us = 5'000;
+        // 每帧的解码耗时在[latency - jitter, latency + jitter]内均匀分布
+        int64_t decode_jitter_us = 0;
+        // 同步模式下返回DecodeStatus::Failed的概率，异步模式下解码器“吞掉”这一帧的概率
+        double failure_rate = 0.0;
+        uint32_t seed = 1;
+    };
+
+public:
+    // params.async为true时返回基于FakeAsyncCodec的AsyncVideoDecoder
+    static std::unique_ptr<VideoDecoder> create(const Params& params,
+                                                const FakeParams& fake_params);
+    FakeVideoDecoder(const Params& params, const FakeParams& fake_params);
+    DecodedFrame decode(const uint8_t* data, uint32_t size) override;
+    std::vector<void*> textures() override;
+
+private:
+    const FakeParams fake_params_;
+    std::mt19937 random_engine_;
+    int64_t frame_no_ = 0;
+};
+
+} // namespace lt
@@ -0,0 +1,194 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ndk_async_codec.h"
+
+#include <dlfcn.h>
+
+#include <ltlib/logging.h>
+
+namespace {
+
+// 和NDK头文件里的AMediaCodecOnAsyncNotifyCallback布局一致. minSdk低于28时头文件不提供这些声明
+struct AsyncNotifyCallback {
+    void (*on_input_available)(AMediaCodec*, void*, int32_t);
+    void (*on_output_available)(AMediaCodec*, void*, int32_t, AMediaCodecBufferInfo*);
+    void (*on_format_changed)(AMediaCodec*, void*, AMediaFormat*);
+    void (*on_error)(AMediaCodec*, void*, media_status_t, int32_t, const char*);
+};
+
+using SetAsyncNotifyCallbackFunc = media_status_t (*)(AMediaCodec*, AsyncNotifyCallback, void*);
+
+SetAsyncNotifyCallbackFunc loadSetAsyncNotifyCallback() {
+    static SetAsyncNotifyCallbackFunc func = []() -> SetAsyncNotifyCallbackFunc {
+        void* handle = dlopen("libmediandk.so", RTLD_NOW);
+        if (handle == nullptr) {
+            return nullptr;
+        }
+        return reinterpret_cast<SetAsyncNotifyCallbackFunc>(
+            dlsym(handle, "AMediaCodec_setAsyncNotifyCallback"));
+    }();
+    return func;
+}
+
+} // namespace
+
+namespace lt {
+
+std::unique_ptr<NdkAsyncCodec> NdkAsyncCodec::create(VideoCodecType codec_type,
+                                                     ANativeWindow* window) {
+    if (loadSetAsyncNotifyCallback() == nullptr) {
+        LOG(INFO) << "AMediaCodec_setAsyncNotifyCallback not available";
+        return nullptr;
+    }
+    return std::unique_ptr<NdkAsyncCodec>{new NdkAsyncCodec{codec_type, window}};
+}
+
+NdkAsyncCodec::NdkAsyncCodec(VideoCodecType codec_type, ANativeWindow* window)
+    : codec_type_{codec_type}
+    , a_native_window_{window} {}
+
+NdkAsyncCodec::~NdkAsyncCodec() {
+    stop();
+}
+
+bool NdkAsyncCodec::start(const Callbacks& callbacks) {
+    callbacks_ = callbacks;
+    const char* mime = nullptr;
+    switch (codec_type_) {
+    case lt::VideoCodecType::H264:
+        mime = "video/avc";
+        break;
+    case lt::VideoCodecType::H265:
+        mime = "video/hevc";
+        break;
+    default:
+        LOG(ERR) << "Unknown video codec type " << (int)codec_type_;
+        return false;
+    }
+    media_codec_ = AMediaCodec_createDecoderByType(mime);
+    if (media_codec_ == nullptr) {
+        LOGF(ERR, "AMediaCodec_createDecoderByType(%s) failed", mime);
+        return false;
+    }
+    AMediaFormat* media_format = AMediaFormat_new();
+    if (media_format == nullptr) {
+        LOG(ERR) << "AMediaFormat_new failed";
+        return false;
+    }
+    AMediaFormat_setString(media_format, AMEDIAFORMAT_KEY_MIME, mime);
+    AMediaFormat_setInt32(media_format, AMEDIAFORMAT_KEY_WIDTH,
+                          ANativeWindow_getWidth(a_native_window_));
+    AMediaFormat_setInt32(media_format, AMEDIAFORMAT_KEY_HEIGHT,
+                          ANativeWindow_getHeight(a_native_window_));
+    AMediaFormat_setInt32(media_format, AMEDIAFORMAT_KEY_FRAME_RATE, 60);
+    LOG(INFO) << "Init async AMediaFormat: " << AMediaFormat_toString(media_format);
+    // 异步回调必须在configure之前设置
+    AsyncNotifyCallback notify_callback{};
+    notify_callback.on_input_available = &NdkAsyncCodec::onAsyncInputAvailable;
+    notify_callback.on_output_available = &NdkAsyncCodec::onAsyncOutputAvailable;
+    notify_callback.on_format_changed = &NdkAsyncCodec::onAsyncFormatChanged;
+    notify_callback.on_error = &NdkAsyncCodec::onAsyncError;
+    media_status_t status = loadSetAsyncNotifyCallback()(media_codec_, notify_callback, this);
+    if (status != AMEDIA_OK) {
+        LOG(ERR) << "AMediaCodec_setAsyncNotifyCallback failed " << status;
+        AMediaFormat_delete(media_format);
+        return false;
+    }
+    status = AMediaCodec_configure(media_codec_, media_format, a_native_window_, nullptr, 0);
+    AMediaFormat_delete(media_format);
+    if (status != AMEDIA_OK) {
+        LOG(ERR) << "AMediaCodec_configure failed " << status;
+        return false;
+    }
+    status = AMediaCodec_start(media_codec_);
+    if (status != AMEDIA_OK) {
+        LOG(ERR) << "AMediaCodec_start failed " << status;
+        return false;
+    }
+    started_ = true;
+    return true;
+}
+
+void NdkAsyncCodec::stop() {
+    if (media_codec_ == nullptr) {
+        return;
+    }
+    if (started_) {
+        AMediaCodec_stop(media_codec_);
+        started_ = false;
+    }
+    AMediaCodec_delete(media_codec_);
+    media_codec_ = nullptr;
+}
+
+uint8_t* NdkAsyncCodec::inputBuffer(int32_t index, size_t* capacity) {
+    return AMediaCodec_getInputBuffer(media_codec_, static_cast<size_t>(index), capacity);
+}
+
+bool NdkAsyncCodec::queueInput(int32_t index, uint32_t size, int64_t pts) {
+    media_status_t status = AMediaCodec_queueInputBuffer(
+        media_codec_, static_cast<size_t>(index), 0, size, static_cast<uint64_t>(pts), 0);
+    if (status != AMEDIA_OK) {
+        LOG(ERR) << "AMediaCodec_queueInputBuffer failed " << status;
+        return false;
+    }
+    return true;
+}
+
+bool NdkAsyncCodec::releaseOutput(int32_t index, bool render) {
+    return AMediaCodec_releaseOutputBuffer(media_codec_, static_cast<size_t>(index), render) ==
+           AMEDIA_OK;
+}
+
+void NdkAsyncCodec::onAsyncInputAvailable(AMediaCodec*, void* userdata, int32_t index) {
+    auto that = reinterpret_cast<NdkAsyncCodec*>(userdata);
+    that->callbacks_.on_input_available(index);
+}
+
+void NdkAsyncCodec::onAsyncOutputAvailable(AMediaCodec*, void* userdata, int32_t index,
+                                           AMediaCodecBufferInfo* info) {
+    auto that = reinterpret_cast<NdkAsyncCodec*>(userdata);
+    that->callbacks_.on_output_available(index, info->presentationTimeUs);
+}
+
+void NdkAsyncCodec::onAsyncFormatChanged(AMediaCodec*, void*, AMediaFormat* format) {
+    LOG(INFO) << "Async AMediaCodec format changed: " << AMediaFormat_toString(format);
+}
+
+void NdkAsyncCodec::onAsyncError(AMediaCodec*, void* userdata, media_status_t error,
+                                 int32_t action_code, const char* detail) {
+    auto that = reinterpret_cast<NdkAsyncCodec*>(userdata);
+    LOG(ERR) << "Async AMediaCodec error " << error << ", action " << action_code << ", "
+             << (detail ? detail : "");
+    that->callbacks_.on_error(static_cast<int32_t>(error));
+}
+
+} // namespace lt
@@ -0,0 +1,72 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <graphics/decoder/async_codec.h>
+
+#include <memory>
+
+#include <android/native_window.h>
+#include <media/NdkMediaCodec.h>
+
+#include "transport/include/transport/transport.h"
+
+namespace lt {
+
+// MediaCodec的异步模式. AMediaCodec_setAsyncNotifyCallback从API 28才有，运行时查找，
+// 找不到时create()返回nullptr，由调用者退回同步模式
+class NdkAsyncCodec : public AsyncCodec {
+public:
+    static std::unique_ptr<NdkAsyncCodec> create(VideoCodecType codec_type, ANativeWindow* window);
+    ~NdkAsyncCodec() override;
+    bool start(const Callbacks& callbacks) override;
+    void stop() override;
+    uint8_t* inputBuffer(int32_t index, size_t* capacity) override;
+    bool queueInput(int32_t index, uint32_t size, int64_t pts) override;
+    bool releaseOutput(int32_t index, bool render) override;
+
+private:
+    NdkAsyncCodec(VideoCodecType codec_type, ANativeWindow* window);
+    static void onAsyncInputAvailable(AMediaCodec* codec, void* userdata, int32_t index);
+    static void onAsyncOutputAvailable(AMediaCodec* codec, void* userdata, int32_t index,
+                                       AMediaCodecBufferInfo* info);
+    static void onAsyncFormatChanged(AMediaCodec* codec, void* userdata, AMediaFormat* format);
+    static void onAsyncError(AMediaCodec* codec, void* userdata, media_status_t error,
+                             int32_t action_code, const char* detail);
+
+private:
+    const VideoCodecType codec_type_;
+    ANativeWindow* a_native_window_;
+    AMediaCodec* media_codec_ = nullptr;
+    Callbacks callbacks_;
+    bool started_ = false;
+};
+
+} // namespace lt
@@ -33,6 +33,9 @@
 #include <ltlib/logging.h>
 #include <ltlib/times.h>
 
+#include "async_video_decoder.h"
+#include "ndk_async_codec.h"
+
 namespace {
 struct AutoGuard {
     AutoGuard(const std::function<void()>& func)
@@ -50,6 +53,26 @@ private:
 
 namespace lt {
 
+std::unique_ptr<VideoDecoder> NdkVideoDecoder::create(const Params& params) {
+    if (params.async) {
+        auto codec = NdkAsyncCodec::create(params.codec_type,
+                                           reinterpret_cast<ANativeWindow*>(params.hw_context));
+        if (codec != nullptr) {
+            std::unique_ptr<AsyncVideoDecoder> decoder{
+                new AsyncVideoDecoder(params, std::move(codec))};
+            if (decoder->init()) {
+                return decoder;
+            }
+        }
+        LOG(WARNING) << "Create async video decoder failed, fallback to sync mode";
+    }
+    std::unique_ptr<NdkVideoDecoder> decoder{new NdkVideoDecoder(params)};
+    if (!decoder->init()) {
+        return nullptr;
+    }
+    return decoder;
+}
+
 NdkVideoDecoder::NdkVideoDecoder(const VideoDecoder::Params& params)
     : VideoDecoder(params)
     , a_native_window_(reinterpret_cast<ANativeWindow*>(params.hw_context)) {}
@@ -135,10 +158,44 @@ DecodeStatus NdkVideoDecoder::pushFrame(const uint8_t* data, uint32_t size) {
         return DecodeStatus::Failed;
     }
     ::memcpy(buff, data, size);
+    queueInput(static_cast<size_t>(index), size);
+    return DecodeStatus::Success2;
+}
+
+void NdkVideoDecoder::queueInput(size_t index, uint32_t size) {
     // TODO: 确认C++的时间戳和JVM的一致
     auto pts = static_cast<uint64_t>(ltlib::steady_now_us());
     AMediaCodec_queueInputBuffer(media_codec_, index, 0, size, pts, 0);
-    return DecodeStatus::Success2;
+}
+
+std::optional<DecoderInputBuffer> NdkVideoDecoder::acquireInputBuffer(uint32_t size) {
+    ssize_t index = AMediaCodec_dequeueInputBuffer(media_codec_, 0);
+    if (index < 0) {
+        return std::nullopt;
+    }
+    size_t buff_size = 0;
+    uint8_t* buff =
+        AMediaCodec_getInputBuffer(media_codec_, static_cast<size_t>(index), &buff_size);
+    if (buff == nullptr || buff_size < size) {
+        // 已经出队的缓冲区不能扔掉，以空帧的形式还给MediaCodec
+        queueInput(static_cast<size_t>(index), 0);
+        return std::nullopt;
+    }
+    DecoderInputBuffer buffer{};
+    buffer.index = index;
+    buffer.data = buff;
+    buffer.capacity = static_cast<uint32_t>(buff_size);
+    return buffer;
+}
+
+DecodedFrame NdkVideoDecoder::commitInputBuffer(const DecoderInputBuffer& buffer, uint32_t size) {
+    queueInput(static_cast<size_t>(buffer.index), size);
+    if (size == 0) {
+        DecodedFrame frame{};
+        frame.status = DecodeStatus::EAgain;
+        return frame;
+    }
+    return pullFrame();
 }
 
 DecodedFrame NdkVideoDecoder::pullFrame() {
@@ -157,7 +214,7 @@ DecodedFrame NdkVideoDecoder::pullFrame() {
         frame.status = DecodeStatus::Failed;
         return frame;
     }
-    AMediaCodec_releaseOutputBuffer(media_codec_, index, true);
+    AMediaCodec_releaseOutputBuffer(media_codec_, index, renderOutput());
     frame.status = DecodeStatus::Success2;
     frame.frame = 1;
     return frame;
@@ -44,15 +44,20 @@ namespace lt {
 
 class NdkVideoDecoder : public VideoDecoder {
 public:
+    // 设备上VaType::AndroidDummy对应的后端，params.async为true时优先使用异步模式
+    static std::unique_ptr<VideoDecoder> create(const Params& params);
     NdkVideoDecoder(const Params& params);
     ~NdkVideoDecoder() override;
 
     bool init();
     DecodedFrame decode(const uint8_t* data, uint32_t size) override;
     std::vector<void*> textures() override;
+    std::optional<DecoderInputBuffer> acquireInputBuffer(uint32_t size) override;
+    DecodedFrame commitInputBuffer(const DecoderInputBuffer& buffer, uint32_t size) override;
 
 private:
     DecodeStatus pushFrame(const uint8_t* data, uint32_t size);
+    void queueInput(size_t index, uint32_t size);
     DecodedFrame pullFrame();
 
 private:
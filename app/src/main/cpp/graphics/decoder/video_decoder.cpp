@@ -30,28 +30,58 @@
 
 #include "video_decoder.h"
 
+#include <map>
+#include <mutex>
+
 #include <ltlib/logging.h>
 
+#if defined(LT_ANDROID)
 #include "ndk_video_decoder.h"
+#endif
+
+namespace {
+
+std::mutex g_backends_mutex;
+
+std::map<lt::VaType, lt::VideoDecoder::Factory>& backends() {
+    static std::map<lt::VaType, lt::VideoDecoder::Factory> backends = []() {
+        std::map<lt::VaType, lt::VideoDecoder::Factory> builtin;
+#if defined(LT_ANDROID)
+        builtin[lt::VaType::AndroidDummy] = &lt::NdkVideoDecoder::create;
+#endif
+        return builtin;
+    }();
+    return backends;
+}
+
+} // namespace
 
 namespace lt {
 
 std::unique_ptr<VideoDecoder> VideoDecoder::create(const Params& params) {
-    if (params.va_type != VaType::AndroidDummy) {
-        LOG(ERR) << "Only support VaType::AndroidDummy";
-        return nullptr;
+    Factory factory;
+    {
+        std::lock_guard lock{g_backends_mutex};
+        auto iter = backends().find(params.va_type);
+        if (iter != backends().end()) {
+            factory = iter->second;
+        }
     }
-    NdkVideoDecoder::Params ndk_params{};
-    ndk_params.hw_device = params.hw_device;
-    ndk_params.hw_context = params.hw_context;
-    ndk_params.height = params.height;
-    ndk_params.width = params.width;
-    ndk_params.codec_type = params.codec_type;
-    std::unique_ptr<NdkVideoDecoder> decoder {new NdkVideoDecoder(ndk_params)};
-    if (!decoder->init()) {
+    if (factory == nullptr) {
+        LOG(ERR) << "No video decoder backend for VaType " << static_cast<int>(params.va_type);
         return nullptr;
     }
-    return decoder;
+    return factory(params);
+}
+
+void VideoDecoder::registerBackend(VaType va_type, const Factory& factory) {
+    std::lock_guard lock{g_backends_mutex};
+    if (factory == nullptr) {
+        backends().erase(va_type);
+    }
+    else {
+        backends()[va_type] = factory;
+    }
 }
 
 VideoDecoder::VideoDecoder(const Params& params)
@@ -71,4 +101,48 @@ uint32_t VideoDecoder::height() const {
     return height_;
 }
 
+void VideoDecoder::setRenderOutput(bool render) {
+    render_output_ = render;
+}
+
+bool VideoDecoder::renderOutput() const {
+    return render_output_;
+}
+
+std::optional<DecoderInputBuffer> VideoDecoder::acquireInputBuffer(uint32_t size) {
+    (void)size;
+    return std::nullopt;
+}
+
+DecodedFrame VideoDecoder::commitInputBuffer(const DecoderInputBuffer& buffer, uint32_t size) {
+    (void)buffer;
+    (void)size;
+    DecodedFrame frame{};
+    frame.status = DecodeStatus::Failed;
+    return frame;
+}
+
+bool VideoDecoder::isAsync() const {
+    return false;
+}
+
+void VideoDecoder::setNotifier(const std::function<void()>& notifier) {
+    (void)notifier;
+}
+
+DecodeStatus VideoDecoder::submitFrame(const uint8_t* data, uint32_t size, int64_t ltframe_id) {
+    (void)data;
+    (void)size;
+    (void)ltframe_id;
+    return DecodeStatus::Failed;
+}
+
+std::optional<DecodedFrame> VideoDecoder::pollFrame() {
+    return std::nullopt;
+}
+
+uint32_t VideoDecoder::framesInFlight() {
+    return 0;
+}
+
 } // namespace lt
\ No newline at end of file
@@ -29,8 +29,12 @@
  */
 
 #pragma once
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <vector>
 
 #include <graphics/types.h>
 #include "transport/include/transport/transport.h"
@@ -43,6 +47,17 @@ enum class DecodeStatus { Success2, EAgain, Failed };
 struct DecodedFrame {
     DecodeStatus status;
     int64_t frame;
+    // 以下三个字段只在异步模式下有意义
+    int64_t ltframe_id = -1;
+    int64_t decode_time_us = 0;
+    bool render = true;
+};
+
+// 解码器自己持有的输入缓冲区，调用者可以直接把一帧写进去，省掉一次拷贝
+struct DecoderInputBuffer {
+    int64_t index = -1;
+    uint8_t* data = nullptr;
+    uint32_t capacity = 0;
 };
 
 class VideoDecoder {
@@ -54,14 +69,37 @@ public:
         void* hw_device;
         void* hw_context;
         VaType va_type;
+        // 尝试使用异步解码，不支持时退回同步模式
+        bool async = false;
     };
 
+    using Factory = std::function<std::unique_ptr<VideoDecoder>(const Params&)>;
+
 public:
     static std::unique_ptr<VideoDecoder> create(const Params& params);
+    // 注册或替换某种VaType的解码器实现，factory为空表示移除. 可以借此在host上换成假解码器
+    static void registerBackend(VaType va_type, const Factory& factory);
     VideoDecoder(const Params& params);
     virtual ~VideoDecoder() = default;
     virtual DecodedFrame decode(const uint8_t* data, uint32_t size) = 0;
     virtual std::vector<void*> textures() = 0;
+    // 不阻塞地申请一个至少能放下size字节的输入缓冲区，没有空闲的就返回std::nullopt
+    virtual std::optional<DecoderInputBuffer> acquireInputBuffer(uint32_t size);
+    // 提交acquireInputBuffer()拿到的缓冲区并取回解码结果. size为0表示放弃这个缓冲区
+    virtual DecodedFrame commitInputBuffer(const DecoderInputBuffer& buffer, uint32_t size);
+    // 之后送入的帧解码后是否送显. 用于追帧时只解码不显示
+    void setRenderOutput(bool render);
+    bool renderOutput() const;
+
+    // 异步模式. decode()仍然可用，但只有用下面的接口才能让多帧同时在解码器里
+    virtual bool isAsync() const;
+    // 有空闲输入缓冲区或者有新的输出时调用，可能在任意线程
+    virtual void setNotifier(const std::function<void()>& notifier);
+    // 不阻塞，解码器忙时返回EAgain
+    virtual DecodeStatus submitFrame(const uint8_t* data, uint32_t size, int64_t ltframe_id);
+    // 不阻塞，取出一个解码好的帧
+    virtual std::optional<DecodedFrame> pollFrame();
+    virtual uint32_t framesInFlight();
 
     VideoCodecType codecType() const;
     uint32_t width() const;
@@ -71,6 +109,7 @@ private:
     const VideoCodecType codec_type_;
     const uint32_t width_;
     const uint32_t height_;
+    bool render_output_ = true;
 };
 
 } // namespace lt
\ No newline at end of file
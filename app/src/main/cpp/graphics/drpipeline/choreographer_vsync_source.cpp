@@ -0,0 +1,178 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "choreographer_vsync_source.h"
+
+#include <dlfcn.h>
+
+#include <android/looper.h>
+
+#include <ltlib/logging.h>
+
+namespace {
+
+// minSdk低于24时头文件不提供AChoreographer的声明
+using GetInstanceFunc = void* (*)();
+using FrameCallback64 = void (*)(int64_t, void*);
+using FrameCallback = void (*)(long, void*);
+using PostFrameCallback64Func = void (*)(void*, FrameCallback64, void*);
+using PostFrameCallbackFunc = void (*)(void*, FrameCallback, void*);
+
+struct ChoreographerApi {
+    GetInstanceFunc get_instance = nullptr;
+    // API 29. 旧接口的long在32位系统上会溢出，优先用这个
+    PostFrameCallback64Func post_frame_callback64 = nullptr;
+    PostFrameCallbackFunc post_frame_callback = nullptr;
+};
+
+const ChoreographerApi& loadChoreographerApi() {
+    static ChoreographerApi api = []() {
+        ChoreographerApi result;
+        void* handle = dlopen("libandroid.so", RTLD_NOW);
+        if (handle == nullptr) {
+            return result;
+        }
+        result.get_instance =
+            reinterpret_cast<GetInstanceFunc>(dlsym(handle, "AChoreographer_getInstance"));
+        result.post_frame_callback64 = reinterpret_cast<PostFrameCallback64Func>(
+            dlsym(handle, "AChoreographer_postFrameCallback64"));
+        result.post_frame_callback = reinterpret_cast<PostFrameCallbackFunc>(
+            dlsym(handle, "AChoreographer_postFrameCallback"));
+        return result;
+    }();
+    return api;
+}
+
+} // namespace
+
+namespace lt {
+
+std::unique_ptr<ChoreographerVsyncSource> ChoreographerVsyncSource::create(uint32_t refresh_rate) {
+    const auto& api = loadChoreographerApi();
+    if (api.get_instance == nullptr ||
+        (api.post_frame_callback64 == nullptr && api.post_frame_callback == nullptr)) {
+        LOG(INFO) << "AChoreographer not available";
+        return nullptr;
+    }
+    std::unique_ptr<ChoreographerVsyncSource> source{new ChoreographerVsyncSource{refresh_rate}};
+    if (!source->init()) {
+        return nullptr;
+    }
+    return source;
+}
+
+ChoreographerVsyncSource::ChoreographerVsyncSource(uint32_t refresh_rate)
+    : period_us_{1'000'000 / static_cast<int64_t>(refresh_rate)} {}
+
+ChoreographerVsyncSource::~ChoreographerVsyncSource() {
+    stoped_ = true;
+    thread_.reset();
+}
+
+bool ChoreographerVsyncSource::init() {
+    // 只是转发vsync信号，不挑核，但要醒得及时. -8即THREAD_PRIORITY_URGENT_DISPLAY
+    ltlib::ThreadOptions options;
+    options.priority = -8;
+    thread_ = ltlib::BlockingThread::create(
+        "vsync", [this](const std::function<void()>& i_am_alive) { loop(i_am_alive); }, options);
+    std::unique_lock lock{mutex_};
+    cv_.wait(lock, [this]() { return initialized_; });
+    if (choreographer_ == nullptr) {
+        LOG(ERR) << "AChoreographer_getInstance failed";
+        return false;
+    }
+    return true;
+}
+
+void ChoreographerVsyncSource::loop(const std::function<void()>& i_am_alive) {
+    ALooper_prepare(ALOOPER_PREPARE_ALLOW_NON_CALLBACKS);
+    {
+        std::lock_guard lock{mutex_};
+        choreographer_ = loadChoreographerApi().get_instance();
+        initialized_ = true;
+    }
+    cv_.notify_all();
+    if (choreographer_ == nullptr) {
+        return;
+    }
+    postFrameCallback();
+    constexpr int kPollTimeoutMS = 100;
+    while (!stoped_) {
+        i_am_alive();
+        ALooper_pollOnce(kPollTimeoutMS, nullptr, nullptr, nullptr);
+    }
+}
+
+void ChoreographerVsyncSource::postFrameCallback() {
+    const auto& api = loadChoreographerApi();
+    if (api.post_frame_callback64 != nullptr) {
+        api.post_frame_callback64(choreographer_, &ChoreographerVsyncSource::onFrameCallback64,
+                                  this);
+    }
+    else {
+        api.post_frame_callback(choreographer_, &ChoreographerVsyncSource::onFrameCallback, this);
+    }
+}
+
+void ChoreographerVsyncSource::onFrameCallback64(int64_t frame_time_ns, void* userdata) {
+    static_cast<ChoreographerVsyncSource*>(userdata)->onVsync(frame_time_ns);
+}
+
+void ChoreographerVsyncSource::onFrameCallback(long frame_time_ns, void* userdata) {
+    static_cast<ChoreographerVsyncSource*>(userdata)->onVsync(frame_time_ns);
+}
+
+// frame_time_ns是CLOCK_MONOTONIC，与steady_clock一致
+void ChoreographerVsyncSource::onVsync(int64_t frame_time_ns) {
+    {
+        std::lock_guard lock{mutex_};
+        vsync_us_ = frame_time_ns / 1000;
+        vsync_seq_++;
+    }
+    cv_.notify_all();
+    if (!stoped_) {
+        postFrameCallback();
+    }
+}
+
+std::optional<int64_t> ChoreographerVsyncSource::waitForVsync(std::chrono::microseconds max_wait) {
+    std::unique_lock lock{mutex_};
+    const uint64_t seq = vsync_seq_;
+    if (!cv_.wait_for(lock, max_wait, [this, seq]() { return vsync_seq_ != seq; })) {
+        return {};
+    }
+    return vsync_us_;
+}
+
+int64_t ChoreographerVsyncSource::periodUs() const {
+    return period_us_;
+}
+
+} // namespace lt
@@ -0,0 +1,72 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include "vsync_source.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include <ltlib/threads.h>
+
+namespace lt {
+
+// 用AChoreographer接收vsync. 它要求调用线程有ALooper，所以内部起一个线程跑looper.
+// AChoreographer从API 24才有，运行时查找，找不到时create()返回nullptr
+class ChoreographerVsyncSource : public VsyncSource {
+public:
+    static std::unique_ptr<ChoreographerVsyncSource> create(uint32_t refresh_rate);
+    ~ChoreographerVsyncSource() override;
+    std::optional<int64_t> waitForVsync(std::chrono::microseconds max_wait) override;
+    int64_t periodUs() const override;
+
+private:
+    explicit ChoreographerVsyncSource(uint32_t refresh_rate);
+    bool init();
+    void loop(const std::function<void()>& i_am_alive);
+    void postFrameCallback();
+    void onVsync(int64_t frame_time_ns);
+    static void onFrameCallback64(int64_t frame_time_ns, void* userdata);
+    static void onFrameCallback(long frame_time_ns, void* userdata);
+
+private:
+    const int64_t period_us_;
+    void* choreographer_ = nullptr;
+    std::atomic<bool> stoped_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool initialized_ = false;
+    uint64_t vsync_seq_ = 0;
+    int64_t vsync_us_ = 0;
+    std::unique_ptr<ltlib::BlockingThread> thread_;
+};
+
+} // namespace lt
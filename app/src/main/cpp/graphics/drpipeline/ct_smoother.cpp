@@ -30,21 +30,48 @@
 
 #include "ct_smoother.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+namespace {
+
+// 抖动估计的平滑系数，与RFC3550一致取1/16
+constexpr int64_t kJitterGain = 16;
+// 最小传输时延取最近这段时间内的最小值，以适应时钟漂移和路由变化
+constexpr int64_t kBaseTransitWindowUs = 2'000'000;
+// 目标延迟下降时缓慢回落，避免抖动一停就立刻减小缓冲导致反复卡顿
+constexpr int64_t kTargetDecayGain = 64;
+constexpr int64_t kJitterMultiplier = 3;
+constexpr int64_t kMaxTargetDelayUs = 100'000;
+// Smooth模式下最多缓存的帧数，超出时丢弃最老的帧
+constexpr size_t kMaxBufferedFrames = 8;
+
+} // namespace
+
 namespace lt {
 
-// 先不做任何平滑
+CTSmoother::CTSmoother(Mode mode)
+    : mode_{mode} {}
+
 void CTSmoother::push(Frame frame) {
     std::lock_guard<std::mutex> lock(buf_mtx_);
-    frames_.clear();
+    if (frame.capture_time != 0) {
+        updateJitter(frame);
+    }
+    if (mode_ == Mode::LowLatency) {
+        frames_.clear();
+    }
+    else if (frames_.size() >= kMaxBufferedFrames) {
+        frames_.pop_front();
+        dropped_frames_++;
+    }
     frames_.push_back(frame);
 }
 
-void CTSmoother::pop() {
+uint32_t CTSmoother::takeDroppedFrames() {
     std::lock_guard<std::mutex> lock(buf_mtx_);
-    if (frames_.empty()) {
-        return;
-    }
-    frames_.pop_front();
+    return std::exchange(dropped_frames_, 0);
 }
 
 size_t CTSmoother::size() const {
@@ -52,17 +79,96 @@ size_t CTSmoother::size() const {
     return frames_.size();
 }
 
+CTSmoother::Mode CTSmoother::mode() const {
+    return mode_;
+}
+
+int64_t CTSmoother::jitterUs() const {
+    std::lock_guard<std::mutex> lock(buf_mtx_);
+    return jitter_us_;
+}
+
+int64_t CTSmoother::targetDelayUs() const {
+    std::lock_guard<std::mutex> lock(buf_mtx_);
+    return target_delay_us_;
+}
+
 void CTSmoother::clear() {
     std::lock_guard<std::mutex> lock(buf_mtx_);
     frames_.clear();
+    has_transit_ = false;
+    transit_window_.clear();
+    jitter_us_ = 0;
+    target_delay_us_ = 0;
+    dropped_frames_ = 0;
 }
 
-std::optional<CTSmoother::Frame> CTSmoother::get(int64_t at_time) {
-    (void)at_time;
+std::optional<CTSmoother::Frame> CTSmoother::take(int64_t at_time) {
     std::lock_guard<std::mutex> lock(buf_mtx_);
     if (frames_.empty()) {
         return {};
     }
-    return frames_.front();
+    if (mode_ == Mode::Smooth) {
+        // 渲染落后时，跳过后面还有到期帧的帧，追上来
+        while (frames_.size() > 1 && dueTimeLocked(frames_[1]) <= at_time) {
+            frames_.pop_front();
+            dropped_frames_++;
+        }
+        if (dueTimeLocked(frames_.front()) > at_time) {
+            return {};
+        }
+    }
+    Frame frame = frames_.front();
+    frames_.pop_front();
+    return frame;
 }
+
+std::optional<int64_t> CTSmoother::dueTime() const {
+    std::lock_guard<std::mutex> lock(buf_mtx_);
+    if (frames_.empty()) {
+        return {};
+    }
+    if (mode_ == Mode::LowLatency) {
+        return frames_.front().at_time;
+    }
+    return dueTimeLocked(frames_.front());
+}
+
+// 传输时延包含了两端的时钟差，但只用到它的变化量和相对最小值，所以不需要时钟同步
+void CTSmoother::updateJitter(const Frame& frame) {
+    int64_t transit = frame.at_time - frame.capture_time;
+    // 单调队列维护窗口内的最小值
+    while (!transit_window_.empty() && transit_window_.back().second >= transit) {
+        transit_window_.pop_back();
+    }
+    transit_window_.emplace_back(frame.capture_time, transit);
+    while (transit_window_.front().first + kBaseTransitWindowUs < frame.capture_time) {
+        transit_window_.pop_front();
+    }
+    base_transit_ = transit_window_.front().second;
+    if (!has_transit_) {
+        has_transit_ = true;
+        last_transit_ = transit;
+        return;
+    }
+    int64_t d = std::abs(transit - last_transit_);
+    last_transit_ = transit;
+    jitter_us_ += (d - jitter_us_) / kJitterGain;
+    int64_t target = std::min(jitter_us_ * kJitterMultiplier, kMaxTargetDelayUs);
+    if (target > target_delay_us_) {
+        target_delay_us_ = target;
+    }
+    else {
+        target_delay_us_ += (target - target_delay_us_) / kTargetDecayGain;
+    }
+}
+
+int64_t CTSmoother::dueTimeLocked(const Frame& frame) const {
+    if (frame.capture_time == 0) {
+        // 没有采集时间，到了就显示
+        return frame.at_time;
+    }
+    return frame.capture_time + base_transit_ + target_delay_us_;
+}
+
 } // namespace lt
@@ -34,32 +34,71 @@
 #include <deque>
 #include <mutex>
 #include <optional>
+#include <utility>
 
 namespace lt {
 
 // 平滑算法
+// 根据采集时间和到达时间估计网络抖动，维护一个自适应的目标延迟:
+// 帧的显示时间 = 采集时间 + 最小传输时延 + 目标延迟.
 class CTSmoother {
 public:
+    enum class Mode {
+        // 总是显示最新的帧，不做平滑
+        LowLatency,
+        // 按采集节奏匀速显示，用目标延迟吸收抖动
+        Smooth,
+    };
+
     struct Frame {
         int64_t no;
+        int64_t ltframe_id = -1;
 
         int64_t at_time = 0;
         int64_t capture_time = 0;
     };
 
 public:
+    explicit CTSmoother(Mode mode = Mode::LowLatency);
+
+    // capture_time为0表示不知道采集时间(比如异步解码输出对不上输入)，这样的帧不参与抖动估计
     void push(Frame frame);
 
-    void pop();
+    // 取出at_time时应该显示的帧，选帧和出队在同一把锁里完成.
+    // Smooth模式下还没到显示时间则返回空
+    std::optional<Frame> take(int64_t at_time);
 
-    std::optional<Frame> get(int64_t at_time);
+    // Smooth模式下没显示就被丢掉的帧数(缓冲溢出、追赶跳帧)，返回上次调用以来的累计值
+    uint32_t takeDroppedFrames();
+
+    // 队首帧的显示时间，队列为空时返回空
+    std::optional<int64_t> dueTime() const;
 
     void clear();
 
     size_t size() const;
 
+    Mode mode() const;
+
+    int64_t jitterUs() const;
+
+    int64_t targetDelayUs() const;
+
+private:
+    void updateJitter(const Frame& frame);
+    int64_t dueTimeLocked(const Frame& frame) const;
+
 private:
+    const Mode mode_;
     mutable std::mutex buf_mtx_;
     std::deque<Frame> frames_;
+    bool has_transit_ = false;
+    int64_t last_transit_ = 0;
+    int64_t base_transit_ = 0;
+    // (采集时间, 传输时延)
+    std::deque<std::pair<int64_t, int64_t>> transit_window_;
+    int64_t jitter_us_ = 0;
+    int64_t target_delay_us_ = 0;
+    uint32_t dropped_frames_ = 0;
 };
 } // namespace lt
@@ -0,0 +1,148 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "frame_buffer_pool.h"
+
+#include <algorithm>
+
+namespace lt {
+
+FrameBufferPool::Buffer::Buffer(FrameBufferPool* pool, uint8_t* data, uint32_t capacity)
+    : pool_{pool}
+    , data_{data}
+    , capacity_{capacity} {}
+
+FrameBufferPool::Buffer::~Buffer() {
+    reset();
+}
+
+FrameBufferPool::Buffer::Buffer(Buffer&& other) noexcept
+    : pool_{other.pool_}
+    , data_{other.data_}
+    , capacity_{other.capacity_} {
+    other.pool_ = nullptr;
+    other.data_ = nullptr;
+    other.capacity_ = 0;
+}
+
+FrameBufferPool::Buffer& FrameBufferPool::Buffer::operator=(Buffer&& other) noexcept {
+    if (this != &other) {
+        reset();
+        std::swap(pool_, other.pool_);
+        std::swap(data_, other.data_);
+        std::swap(capacity_, other.capacity_);
+    }
+    return *this;
+}
+
+void FrameBufferPool::Buffer::reset() {
+    if (data_ != nullptr) {
+        pool_->release(data_, capacity_);
+    }
+    pool_ = nullptr;
+    data_ = nullptr;
+    capacity_ = 0;
+}
+
+FrameBufferPool::FrameBufferPool() {
+    // 提前分配好空闲链表的空间，归还buffer时不会触发vector扩容
+    for (auto& free_list : free_lists_) {
+        free_list.reserve(kMaxFreePerClass);
+    }
+}
+
+FrameBufferPool::~FrameBufferPool() {
+    for (auto& free_list : free_lists_) {
+        for (auto buff : free_list) {
+            delete[] buff;
+        }
+    }
+}
+
+int32_t FrameBufferPool::sizeClassOf(uint32_t size) {
+    for (int32_t i = 0; i < kNumClasses; i++) {
+        if (size <= (1u << (kMinShift + i))) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+FrameBufferPool::Buffer FrameBufferPool::acquire(uint32_t size) {
+    int32_t size_class = sizeClassOf(size);
+    uint32_t capacity = size_class < 0 ? size : 1u << (kMinShift + size_class);
+    uint8_t* data = nullptr;
+    {
+        std::lock_guard lock{mutex_};
+        if (size_class >= 0 && !free_lists_[size_class].empty()) {
+            data = free_lists_[size_class].back();
+            free_lists_[size_class].pop_back();
+            pooled_bytes_ -= capacity;
+            hits_++;
+        }
+        else {
+            misses_++;
+        }
+        in_use_++;
+        high_water_ = std::max(high_water_, in_use_);
+    }
+    if (data == nullptr) {
+        data = new uint8_t[capacity];
+    }
+    return Buffer{this, data, capacity};
+}
+
+void FrameBufferPool::release(uint8_t* data, uint32_t capacity) {
+    int32_t size_class = sizeClassOf(capacity);
+    {
+        std::lock_guard lock{mutex_};
+        in_use_--;
+        if (size_class >= 0 && capacity == (1u << (kMinShift + size_class)) &&
+            free_lists_[size_class].size() < kMaxFreePerClass) {
+            free_lists_[size_class].push_back(data);
+            pooled_bytes_ += capacity;
+            return;
+        }
+    }
+    delete[] data;
+}
+
+FrameBufferPool::Stat FrameBufferPool::getStat() {
+    std::lock_guard lock{mutex_};
+    Stat stat{};
+    stat.hits = hits_;
+    stat.misses = misses_;
+    stat.in_use = in_use_;
+    stat.high_water = high_water_;
+    stat.pooled_bytes = pooled_bytes_;
+    return stat;
+}
+
+} // namespace lt
@@ -0,0 +1,99 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace lt {
+
+// 编码帧内存池. 按2的幂分级(16KB~8MB)，释放的buffer回到对应级别的空闲链表，
+// 稳态下不再向系统申请内存. 超出最大级别的帧直接new/delete.
+// NOTE: 由使用者保证FrameBufferPool比所有租出的Buffer活得久
+class FrameBufferPool {
+public:
+    class Buffer {
+    public:
+        Buffer() = default;
+        ~Buffer();
+        Buffer(Buffer&& other) noexcept;
+        Buffer& operator=(Buffer&& other) noexcept;
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+        uint8_t* data() const { return data_; }
+        uint32_t capacity() const { return capacity_; }
+        explicit operator bool() const { return data_ != nullptr; }
+        void reset();
+
+    private:
+        friend class FrameBufferPool;
+        Buffer(FrameBufferPool* pool, uint8_t* data, uint32_t capacity);
+
+    private:
+        FrameBufferPool* pool_ = nullptr;
+        uint8_t* data_ = nullptr;
+        uint32_t capacity_ = 0;
+    };
+
+    struct Stat {
+        uint64_t hits;
+        uint64_t misses;
+        uint32_t in_use;
+        uint32_t high_water; // 同时租出的buffer数的最大值
+        uint64_t pooled_bytes;
+    };
+
+public:
+    FrameBufferPool();
+    ~FrameBufferPool();
+    Buffer acquire(uint32_t size);
+    Stat getStat();
+
+private:
+    FrameBufferPool(const FrameBufferPool&) = delete;
+    FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+    void release(uint8_t* data, uint32_t capacity);
+    static int32_t sizeClassOf(uint32_t size);
+
+private:
+    static constexpr uint32_t kMinShift = 14;
+    static constexpr int32_t kNumClasses = 10;
+    static constexpr size_t kMaxFreePerClass = 16;
+    std::mutex mutex_;
+    std::vector<uint8_t*> free_lists_[kNumClasses];
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint32_t in_use_ = 0;
+    uint32_t high_water_ = 0;
+    uint64_t pooled_bytes_ = 0;
+};
+
+} // namespace lt
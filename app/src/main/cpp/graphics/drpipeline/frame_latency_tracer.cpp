@@ -0,0 +1,147 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "frame_latency_tracer.h"
+
+#include <sstream>
+
+namespace {
+
+size_t roundUpToPowerOf2(size_t n) {
+    size_t result = 1;
+    while (result < n) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+namespace lt {
+
+FrameLatencyTracer::FrameLatencyTracer(size_t capacity)
+    : mask_{roundUpToPowerOf2(capacity) - 1}
+    , slots_{new Slot[mask_ + 1]} {}
+
+void FrameLatencyTracer::begin(uint64_t ltframe_id, int64_t capture_us, int64_t encode_start_us,
+                               int64_t encode_end_us, int64_t arrive_us) {
+    Slot& s = slot(ltframe_id);
+    // 先作废槽位，防止其它线程把旧帧的时间写进来
+    s.id.store(kInvalidId, std::memory_order_relaxed);
+    for (auto& t : s.times) {
+        t.store(0, std::memory_order_relaxed);
+    }
+    s.times[static_cast<size_t>(Stage::Capture)].store(capture_us, std::memory_order_relaxed);
+    s.times[static_cast<size_t>(Stage::EncodeStart)].store(encode_start_us,
+                                                          std::memory_order_relaxed);
+    s.times[static_cast<size_t>(Stage::EncodeEnd)].store(encode_end_us, std::memory_order_relaxed);
+    s.times[static_cast<size_t>(Stage::Arrive)].store(arrive_us, std::memory_order_relaxed);
+    s.id.store(ltframe_id, std::memory_order_release);
+}
+
+void FrameLatencyTracer::mark(uint64_t ltframe_id, Stage stage, int64_t time_us) {
+    Slot& s = slot(ltframe_id);
+    if (s.id.load(std::memory_order_acquire) != ltframe_id) {
+        return;
+    }
+    s.times[static_cast<size_t>(stage)].store(time_us, std::memory_order_relaxed);
+}
+
+void FrameLatencyTracer::finish(uint64_t ltframe_id, int64_t present_us) {
+    Slot& s = slot(ltframe_id);
+    if (s.id.load(std::memory_order_acquire) != ltframe_id) {
+        return;
+    }
+    std::array<int64_t, kStageCount> times;
+    for (size_t i = 0; i < kStageCount; i++) {
+        times[i] = s.times[i].load(std::memory_order_relaxed);
+    }
+    times[static_cast<size_t>(Stage::Present)] = present_us;
+    // 没有打点的阶段(比如还没同步时钟时对端的时间)跳过，不和前后阶段算差值
+    for (size_t i = 0; i + 1 < kStageCount; i++) {
+        if (times[i] != 0 && times[i + 1] != 0) {
+            histograms_[i].record(times[i + 1] - times[i]);
+        }
+    }
+    const int64_t capture = times[static_cast<size_t>(Stage::Capture)];
+    if (capture != 0) {
+        histograms_[kIntervalCount - 1].record(present_us - capture);
+    }
+    s.id.store(kInvalidId, std::memory_order_relaxed);
+}
+
+FrameLatencyTracer::Percentiles FrameLatencyTracer::percentiles(size_t interval) const {
+    Percentiles result;
+    if (interval >= kIntervalCount) {
+        return result;
+    }
+    const auto& histogram = histograms_[interval];
+    result.count = histogram.count();
+    result.p50 = histogram.percentile(50);
+    result.p95 = histogram.percentile(95);
+    result.p99 = histogram.percentile(99);
+    return result;
+}
+
+const char* FrameLatencyTracer::intervalName(size_t interval) {
+    static const char* kNames[kIntervalCount] = {
+        "capture->encode",
+        "encode",
+        "network",
+        "arrive->enqueue",
+        "queue",
+        "decode",
+        "decode->render",
+        "render",
+        "capture->present",
+    };
+    return interval < kIntervalCount ? kNames[interval] : "unknown";
+}
+
+std::string FrameLatencyTracer::summary() const {
+    std::ostringstream oss;
+    oss << "Frame latency(us) p50/p95/p99:";
+    for (size_t i = 0; i < kIntervalCount; i++) {
+        auto p = percentiles(i);
+        if (p.count == 0) {
+            continue;
+        }
+        oss << " " << intervalName(i) << "=" << p.p50 << "/" << p.p95 << "/" << p.p99;
+    }
+    return oss.str();
+}
+
+void FrameLatencyTracer::reset() {
+    for (auto& histogram : histograms_) {
+        histogram.reset();
+    }
+}
+
+} // namespace lt
@@ -0,0 +1,110 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <ltlib/histogram.h>
+
+namespace lt {
+
+// 逐帧记录从采集到上屏各个阶段的时间点，帧上屏后把相邻阶段的耗时汇总进直方图.
+// 记录放在按ltframe_id取模的预分配环形数组里，打点只有几次relaxed原子操作，可以常开.
+// 时间戳统一用本地的steady_now_us()时基，对端的时间由调用者换算好.
+class FrameLatencyTracer {
+public:
+    enum class Stage : uint8_t {
+        Capture,
+        EncodeStart,
+        EncodeEnd,
+        Arrive,
+        Enqueue,
+        DecodeStart,
+        DecodeEnd,
+        Render,
+        Present,
+        Count,
+    };
+    static constexpr size_t kStageCount = static_cast<size_t>(Stage::Count);
+    // 相邻阶段之间各一段，最后一段是采集到上屏的总耗时
+    static constexpr size_t kIntervalCount = kStageCount;
+
+    struct Percentiles {
+        uint64_t count = 0;
+        int64_t p50 = 0;
+        int64_t p95 = 0;
+        int64_t p99 = 0;
+    };
+
+public:
+    // capacity会向上取到2的幂
+    explicit FrameLatencyTracer(size_t capacity = 256);
+
+    // 帧到达时调用，占用ltframe_id对应的槽位. 不知道的时间传0
+    void begin(uint64_t ltframe_id, int64_t capture_us, int64_t encode_start_us,
+               int64_t encode_end_us, int64_t arrive_us);
+
+    // 槽位已经被更新的帧占用时忽略
+    void mark(uint64_t ltframe_id, Stage stage, int64_t time_us);
+
+    // 标记Present并把这一帧汇总进直方图
+    void finish(uint64_t ltframe_id, int64_t present_us);
+
+    // interval取[0, kIntervalCount)
+    Percentiles percentiles(size_t interval) const;
+
+    static const char* intervalName(size_t interval);
+
+    // 每段一行的p50/p95/p99汇总，给日志用
+    std::string summary() const;
+
+    void reset();
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> id{kInvalidId};
+        std::array<std::atomic<int64_t>, kStageCount> times{};
+    };
+    static constexpr uint64_t kInvalidId = ~uint64_t{0};
+
+    Slot& slot(uint64_t ltframe_id) { return slots_[ltframe_id & mask_]; }
+
+private:
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::array<ltlib::Histogram, kIntervalCount> histograms_;
+};
+
+} // namespace lt
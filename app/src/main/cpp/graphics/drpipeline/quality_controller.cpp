@@ -0,0 +1,225 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "quality_controller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+// 和VsyncSource一样，不知道刷新率时按60Hz
+constexpr uint32_t kDefaultMaxFps = 60;
+// 连续过载多少个周期才降级
+constexpr uint32_t kDowngradePeriods = 2;
+// 连续健康多少个周期才升级，比降级慢得多
+constexpr uint32_t kUpgradePeriods = 10;
+// 每次调整后等待多少个周期，让host生效并让统计反映新配置
+constexpr uint32_t kHoldPeriods = 3;
+constexpr size_t kDelayWindowPeriods = 30;
+// 时延比基线高出这么多认为链路在排队
+constexpr uint32_t kDelayExcessUs = 30'000;
+// 万分比
+constexpr uint32_t kCongestedLossRate = 200;
+constexpr uint32_t kSevereLossRate = 1000;
+// 码率变化小于5%不发
+constexpr double kMinBitrateChange = 0.05;
+
+} // namespace
+
+namespace lt {
+
+std::string QualityController::Target::toString() const {
+    std::ostringstream oss;
+    oss << "bitrate:" << bitrate_bps << "bps fps:" << fps;
+    return oss.str();
+}
+
+QualityController::QualityController(const Params& params)
+    : params_{params} {
+    const uint32_t max_fps =
+        std::max(params_.max_fps == 0 ? kDefaultMaxFps : params_.max_fps, params_.min_fps);
+    for (uint32_t fps : {max_fps, max_fps * 3 / 4, max_fps / 2, params_.min_fps}) {
+        if (fps >= params_.min_fps && (fps_levels_.empty() || fps < fps_levels_.back())) {
+            fps_levels_.push_back(fps);
+        }
+    }
+    target_.bitrate_bps = std::clamp(params_.initial_bitrate_bps, params_.min_bitrate_bps,
+                                     params_.max_bitrate_bps);
+    target_.fps = fps_levels_.front();
+}
+
+void QualityController::setUserBitrate(uint32_t bps) {
+    user_bitrate_bps_ = bps;
+    if (bps != 0) {
+        target_.bitrate_bps = bps;
+    }
+    congested_periods_ = 0;
+    clear_periods_ = 0;
+}
+
+std::optional<QualityController::Target> QualityController::update(const ReceiveSideStat& stat,
+                                                                   uint32_t bwe_bps) {
+    // 拥塞判断依赖时延基线，冷却期间也要更新
+    const bool congested = isNetworkCongested(stat, bwe_bps);
+    if (stat.receive_fps == 0) {
+        // 没有收到视频(比如画面静止)，统计没有意义
+        return std::nullopt;
+    }
+    if (isClientOverloaded(stat)) {
+        overload_periods_++;
+        healthy_periods_ = 0;
+    }
+    else if (isClientHealthy(stat)) {
+        healthy_periods_++;
+        overload_periods_ = 0;
+    }
+    else {
+        overload_periods_ = 0;
+        healthy_periods_ = 0;
+    }
+    if (congested) {
+        congested_periods_++;
+        clear_periods_ = 0;
+    }
+    else {
+        clear_periods_++;
+        congested_periods_ = 0;
+    }
+    if (hold_periods_ > 0) {
+        hold_periods_--;
+        return std::nullopt;
+    }
+    const bool client_changed = adjustClient();
+    const bool bitrate_changed = adjustBitrate(stat, bwe_bps);
+    if (!client_changed && !bitrate_changed) {
+        return std::nullopt;
+    }
+    hold_periods_ = kHoldPeriods;
+    return target_;
+}
+
+bool QualityController::isClientOverloaded(const ReceiveSideStat& stat) const {
+    const uint32_t frame_interval_us = 1'000'000 / std::max(stat.receive_fps, 1u);
+    // 解码中位数吃掉了八成帧间隔，或者解码队列在堆积
+    if (stat.decode_p50_us > frame_interval_us * 4 / 5 || stat.decode_queue_depth >= 3) {
+        return true;
+    }
+    // 排队太久被丢掉的帧
+    if (stat.dropped_frames > stat.receive_fps / 20) {
+        return true;
+    }
+    // 超过一成的vsync没赶上，渲染线程忙不过来
+    return stat.present_fps > 0 && stat.missed_vsyncs > stat.present_fps / 10;
+}
+
+bool QualityController::isClientHealthy(const ReceiveSideStat& stat) const {
+    const uint32_t frame_interval_us = 1'000'000 / std::max(stat.receive_fps, 1u);
+    return stat.decode_p99_us < frame_interval_us / 2 && stat.decode_queue_depth <= 1 &&
+           stat.dropped_frames == 0 && stat.missed_vsyncs <= stat.present_fps / 50;
+}
+
+bool QualityController::isNetworkCongested(const ReceiveSideStat& stat, uint32_t bwe_bps) {
+    bool rising = false;
+    if (stat.net_delay_p50_us != 0) {
+        delay_window_.push_back(stat.net_delay_p50_us);
+        if (delay_window_.size() > kDelayWindowPeriods) {
+            delay_window_.pop_front();
+        }
+        const uint32_t base = *std::min_element(delay_window_.begin(), delay_window_.end());
+        rising = stat.net_delay_p50_us > base + kDelayExcessUs;
+    }
+    if (stat.loss_rate >= kCongestedLossRate || rising) {
+        return true;
+    }
+    return bwe_bps != 0 && bwe_bps < target_.bitrate_bps * 0.9;
+}
+
+bool QualityController::adjustClient() {
+    if (overload_periods_ >= kDowngradePeriods) {
+        overload_periods_ = 0;
+        // 帧率降一档解码压力就成比例下降
+        if (fps_level_ + 1 < fps_levels_.size()) {
+            fps_level_++;
+        }
+        else {
+            return false;
+        }
+    }
+    else if (healthy_periods_ >= kUpgradePeriods) {
+        healthy_periods_ = 0;
+        if (fps_level_ > 0) {
+            fps_level_--;
+        }
+        else {
+            return false;
+        }
+    }
+    else {
+        return false;
+    }
+    target_.fps = fps_levels_[fps_level_];
+    return true;
+}
+
+bool QualityController::adjustBitrate(const ReceiveSideStat& stat, uint32_t bwe_bps) {
+    if (user_bitrate_bps_ != 0) {
+        return false;
+    }
+    const double current = target_.bitrate_bps;
+    double next = current;
+    if (!bitrate_seeded_ && bwe_bps != 0) {
+        bitrate_seeded_ = true;
+        next = bwe_bps * 0.9;
+    }
+    else if (congested_periods_ >= kDowngradePeriods || stat.loss_rate >= kSevereLossRate) {
+        congested_periods_ = 0;
+        next = current * 0.8;
+        if (bwe_bps != 0) {
+            next = std::min(next, bwe_bps * 0.9);
+        }
+    }
+    else if (clear_periods_ >= kUpgradePeriods / 2) {
+        clear_periods_ = 0;
+        next = current * 1.08;
+        if (bwe_bps != 0) {
+            next = std::min(next, bwe_bps * 0.95);
+        }
+    }
+    next = std::clamp<double>(next, params_.min_bitrate_bps, params_.max_bitrate_bps);
+    if (std::abs(next - current) < current * kMinBitrateChange) {
+        return false;
+    }
+    target_.bitrate_bps = static_cast<uint32_t>(next);
+    return true;
+}
+
+} // namespace lt
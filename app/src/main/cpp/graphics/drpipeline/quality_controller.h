@@ -0,0 +1,105 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "receive_side_stat.h"
+
+namespace lt {
+
+// 客户端驱动的码率/帧率控制.
+// 每个统计周期喂一次ReceiveSideStat和BWE，分两条线判断:
+//   客户端过载(解码跟不上、掉vsync) -> 逐档降帧率，恢复时逐档升回去
+//   网络拥塞(丢包、时延上涨、BWE低于当前码率) -> 降码率
+// 降级要连续几个周期过载，升级要连续更多周期健康，每次调整后冷却几个周期，避免来回抖.
+// 只在统计线程使用，不加锁.
+class QualityController {
+public:
+    struct Params {
+        // 一般是屏幕刷新率，0表示未知，按60处理
+        uint32_t max_fps = 60;
+        uint32_t min_fps = 20;
+        uint32_t min_bitrate_bps = 500'000;
+        uint32_t max_bitrate_bps = 40'000'000;
+        // 还没有BWE时的起始码率
+        uint32_t initial_bitrate_bps = 10'000'000;
+    };
+
+    struct Target {
+        uint32_t bitrate_bps = 0;
+        uint32_t fps = 0;
+        // ReconfigureVideoEncoder还没有分辨率字段，过载时暂时只能降帧率
+
+        std::string toString() const;
+    };
+
+public:
+    explicit QualityController(const Params& params);
+
+    // 返回有变化的目标，没变化返回空
+    std::optional<Target> update(const ReceiveSideStat& stat, uint32_t bwe_bps);
+
+    // 用户在界面上手动设置码率，0代表自动
+    void setUserBitrate(uint32_t bps);
+
+    bool isAutoBitrate() const { return user_bitrate_bps_ == 0; }
+
+    const Target& target() const { return target_; }
+
+private:
+    bool isClientOverloaded(const ReceiveSideStat& stat) const;
+    bool isClientHealthy(const ReceiveSideStat& stat) const;
+    bool isNetworkCongested(const ReceiveSideStat& stat, uint32_t bwe_bps);
+    bool adjustClient();
+    bool adjustBitrate(const ReceiveSideStat& stat, uint32_t bwe_bps);
+
+private:
+    const Params params_;
+    std::vector<uint32_t> fps_levels_;
+    size_t fps_level_ = 0;
+    Target target_;
+    uint32_t user_bitrate_bps_ = 0;
+    bool bitrate_seeded_ = false;
+    uint32_t overload_periods_ = 0;
+    uint32_t healthy_periods_ = 0;
+    uint32_t congested_periods_ = 0;
+    uint32_t clear_periods_ = 0;
+    uint32_t hold_periods_ = 0;
+    // 最近一段时间net_delay p50，取最小值作为无排队时的基线
+    std::deque<uint32_t> delay_window_;
+};
+
+} // namespace lt
@@ -0,0 +1,90 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "receive_side_stat.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+uint32_t clampU32(int64_t value) {
+    constexpr int64_t kMax = std::numeric_limits<uint32_t>::max();
+    return static_cast<uint32_t>(std::clamp<int64_t>(value, 0, kMax));
+}
+
+uint32_t clampU32(double value) {
+    return clampU32(static_cast<int64_t>(value));
+}
+
+} // namespace
+
+namespace lt {
+
+ReceiveSideStat ReceiveSideStat::fromStat(const VideoStatistics::Stat& stat,
+                                          const VideoStatistics::Stat* prev, uint32_t period_ms) {
+    ReceiveSideStat report;
+    report.period_ms = period_ms;
+    report.receive_fps = clampU32(stat.encode_fps);
+    report.render_fps = clampU32(stat.render_video_fps);
+    report.present_fps = clampU32(stat.present_fps);
+    report.video_kbps = clampU32(stat.video_bw.history.empty() ? 0 : stat.video_bw.history.back());
+    report.decode_p50_us = clampU32(stat.decode_time.last_1s.p50);
+    report.decode_p99_us = clampU32(stat.decode_time.last_1s.p99);
+    report.render_p50_us = clampU32(stat.render_video_time.last_1s.p50);
+    report.render_p99_us = clampU32(stat.render_video_time.last_1s.p99);
+    report.present_p99_us = clampU32(stat.present_time.last_1s.p99);
+    report.net_delay_p50_us = clampU32(stat.net_delay.last_1s.p50);
+    report.net_delay_p99_us = clampU32(stat.net_delay.last_1s.p99);
+    report.dropped_frames =
+        clampU32(stat.dropped_frames - (prev == nullptr ? 0 : prev->dropped_frames));
+    report.missed_vsyncs =
+        clampU32(stat.missed_vsyncs - (prev == nullptr ? 0 : prev->missed_vsyncs));
+    report.loss_rate =
+        clampU32(stat.loss_rate.history.empty() ? 0 : stat.loss_rate.history.back() * 100);
+    return report;
+}
+
+std::string ReceiveSideStat::toString() const {
+    std::ostringstream oss;
+    oss << "ReceiveSideStat{fps recv/render/present:" << receive_fps << "/" << render_fps << "/"
+        << present_fps << ", kbps:" << video_kbps << ", decode p50/p99:" << decode_p50_us << "/"
+        << decode_p99_us << ", render p50/p99:" << render_p50_us << "/" << render_p99_us
+        << ", present p99:" << present_p99_us << ", net p50/p99:" << net_delay_p50_us << "/"
+        << net_delay_p99_us << ", dropped:" << dropped_frames << ", missed_vsync:" << missed_vsyncs
+        << ", queue decode/in_flight/render:" << decode_queue_depth << "/" << decoder_in_flight
+        << "/" << render_queue_depth << ", jitter:" << jitter_us
+        << ", jitter_buffer:" << jitter_buffer_us << ", nack:" << nack
+        << ", loss:" << loss_rate << "}";
+    return oss.str();
+}
+
+} // namespace lt
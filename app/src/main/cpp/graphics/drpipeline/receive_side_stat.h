@@ -0,0 +1,74 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "video_statistics.h"
+
+namespace lt {
+
+// 接收端统计，每个统计周期生成一份，喂给QualityController，让编码参数除了网络状况外
+// 也能根据客户端的瓶颈调整. 耗时单位us，分布取最近一秒.
+// 报告本身只在客户端用，host看到的是QualityController算出来的ReconfigureVideoEncoder
+struct ReceiveSideStat {
+    uint32_t period_ms = 0;
+    uint32_t receive_fps = 0;
+    uint32_t render_fps = 0;
+    uint32_t present_fps = 0;
+    uint32_t video_kbps = 0;
+    uint32_t decode_p50_us = 0;
+    uint32_t decode_p99_us = 0;
+    uint32_t render_p50_us = 0;
+    uint32_t render_p99_us = 0;
+    uint32_t present_p99_us = 0;
+    uint32_t net_delay_p50_us = 0;
+    uint32_t net_delay_p99_us = 0;
+    // 以下两项是本周期内的增量
+    uint32_t dropped_frames = 0;
+    uint32_t missed_vsyncs = 0;
+    uint32_t decode_queue_depth = 0;
+    uint32_t decoder_in_flight = 0;
+    uint32_t render_queue_depth = 0;
+    uint32_t jitter_us = 0;
+    uint32_t jitter_buffer_us = 0;
+    uint32_t nack = 0;
+    // 万分比
+    uint32_t loss_rate = 0;
+
+    // 统计中与队列无关的字段从stat取，增量字段相对prev计算
+    static ReceiveSideStat fromStat(const VideoStatistics::Stat& stat,
+                                    const VideoStatistics::Stat* prev, uint32_t period_ms);
+    std::string toString() const;
+};
+
+} // namespace lt
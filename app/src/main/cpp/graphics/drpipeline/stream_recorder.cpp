@@ -0,0 +1,186 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "stream_recorder.h"
+
+#include <cstring>
+
+#include <ltlib/logging.h>
+
+namespace lt {
+
+using namespace stream_record;
+using namespace std::chrono_literals;
+
+std::unique_ptr<StreamRecorder> StreamRecorder::create(const std::string& path,
+                                                       VideoCodecType codec, uint32_t width,
+                                                       uint32_t height) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        LOG(ERR) << "Open stream record file '" << path << "' failed";
+        return nullptr;
+    }
+    FileHeader header{};
+    header.magic = kFileMagic;
+    header.version = kVersion;
+    header.codec = static_cast<uint32_t>(codec);
+    header.width = width;
+    header.height = height;
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        LOG(ERR) << "Write stream record header failed";
+        std::fclose(file);
+        return nullptr;
+    }
+    std::unique_ptr<StreamRecorder> recorder{new StreamRecorder{file, path}};
+    recorder->offset_ = sizeof(header);
+    // 只是写文件，放到小核上，别和解码渲染抢. 10即THREAD_PRIORITY_BACKGROUND
+    ltlib::ThreadOptions options;
+    options.priority = 10;
+    options.cores = ltlib::ThreadOptions::Cores::Little;
+    recorder->thread_ = ltlib::BlockingThread::create(
+        "stream_recorder",
+        [that = recorder.get()](const std::function<void()>& i_am_alive) {
+            that->writeLoop(i_am_alive);
+        },
+        options);
+    LOG(INFO) << "Recording video stream to " << path;
+    return recorder;
+}
+
+StreamRecorder::StreamRecorder(std::FILE* file, const std::string& path)
+    : path_{path}
+    , file_{file} {}
+
+StreamRecorder::~StreamRecorder() {
+    stoped_ = true;
+    event_.notify();
+    thread_.reset();
+    writeIndex();
+    std::fclose(file_);
+    auto stat = getStat();
+    LOG(INFO) << "Stream record '" << path_ << "' closed, frames:" << stat.recorded_frames
+              << ", dropped:" << stat.dropped_frames << ", bytes:" << stat.bytes;
+}
+
+void StreamRecorder::record(const lt::VideoFrame& frame, int64_t arrival_us,
+                            int64_t time_diff_us) {
+    if (pending_bytes_.load(std::memory_order_relaxed) + frame.size > kMaxPendingBytes) {
+        dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Entry entry;
+    entry.header.magic = kFrameMagic;
+    entry.header.size = frame.size;
+    entry.header.ltframe_id = frame.ltframe_id;
+    entry.header.flags = frame.is_keyframe ? kKeyframeFlag : 0;
+    entry.header.width = frame.width;
+    entry.header.height = frame.height;
+    entry.header.capture_timestamp_us = frame.capture_timestamp_us;
+    entry.header.start_encode_timestamp_us = frame.start_encode_timestamp_us;
+    entry.header.end_encode_timestamp_us = frame.end_encode_timestamp_us;
+    entry.header.arrival_us = arrival_us;
+    entry.header.time_diff_us = time_diff_us;
+    entry.data = pool_.acquire(frame.size);
+    memcpy(entry.data.data(), frame.data, frame.size);
+    if (!queue_.try_push(std::move(entry))) {
+        dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    pending_bytes_.fetch_add(frame.size, std::memory_order_relaxed);
+    event_.notify();
+}
+
+StreamRecorder::Stat StreamRecorder::getStat() const {
+    Stat stat{};
+    stat.recorded_frames = recorded_frames_.load(std::memory_order_relaxed);
+    stat.dropped_frames = dropped_frames_.load(std::memory_order_relaxed);
+    stat.bytes = bytes_.load(std::memory_order_relaxed);
+    return stat;
+}
+
+void StreamRecorder::writeLoop(const std::function<void()>& i_am_alive) {
+    Entry entry;
+    for (;;) {
+        i_am_alive();
+        auto key = event_.prepare_wait();
+        if (!queue_.empty() || stoped_) {
+            event_.cancel_wait();
+        }
+        else {
+            event_.wait_for(key, 100ms);
+        }
+        // 停止前把队列里剩下的帧写完
+        while (queue_.try_pop(entry)) {
+            pending_bytes_.fetch_sub(entry.header.size, std::memory_order_relaxed);
+            if (!write_failed_ && !writeEntry(entry)) {
+                write_failed_ = true;
+                LOG(ERR) << "Write stream record '" << path_ << "' failed, stop recording";
+            }
+            if (write_failed_) {
+                dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+            }
+            entry.data.reset();
+        }
+        if (stoped_) {
+            break;
+        }
+    }
+}
+
+bool StreamRecorder::writeEntry(Entry& entry) {
+    if (std::fwrite(&entry.header, sizeof(entry.header), 1, file_) != 1 ||
+        std::fwrite(entry.data.data(), 1, entry.header.size, file_) != entry.header.size) {
+        return false;
+    }
+    index_.push_back(
+        IndexEntry{offset_, entry.header.ltframe_id, entry.header.arrival_us, entry.header.flags});
+    offset_ += sizeof(entry.header) + entry.header.size;
+    recorded_frames_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(sizeof(entry.header) + entry.header.size, std::memory_order_relaxed);
+    return true;
+}
+
+// 写线程已经退出，在析构的线程里调用
+void StreamRecorder::writeIndex() {
+    if (write_failed_) {
+        return;
+    }
+    Trailer trailer{};
+    trailer.index_offset = offset_;
+    trailer.count = static_cast<uint32_t>(index_.size());
+    trailer.magic = kIndexMagic;
+    if ((!index_.empty() &&
+         std::fwrite(index_.data(), sizeof(IndexEntry), index_.size(), file_) != index_.size()) ||
+        std::fwrite(&trailer, sizeof(trailer), 1, file_) != 1) {
+        LOG(ERR) << "Write stream record index failed";
+    }
+}
+
+} // namespace lt
@@ -0,0 +1,155 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ltlib/event_count.h>
+#include <ltlib/spsc_queue.h>
+#include <ltlib/threads.h>
+
+#include "frame_buffer_pool.h"
+#include "transport/include/transport/transport.h"
+
+namespace lt {
+
+// 录制文件格式(小端):
+//   FileHeader
+//   (FrameHeader + 帧数据) * N
+//   IndexEntry * N + Trailer        正常关闭时才有，没有的话回放时顺序扫描
+namespace stream_record {
+
+constexpr uint32_t kFileMagic = 0x4345524c;  // "LREC"
+constexpr uint32_t kFrameMagic = 0x4d415246; // "FRAM"
+constexpr uint32_t kIndexMagic = 0x5849444c; // "LDIX"
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kKeyframeFlag = 1;
+
+#pragma pack(push, 1)
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t codec; // lt::VideoCodecType
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+};
+
+struct FrameHeader {
+    uint32_t magic;
+    uint32_t size;
+    uint64_t ltframe_id;
+    uint32_t flags;
+    uint32_t width;
+    uint32_t height;
+    // 以下三个是host时钟
+    int64_t capture_timestamp_us;
+    int64_t start_encode_timestamp_us;
+    int64_t end_encode_timestamp_us;
+    // 本地steady时钟
+    int64_t arrival_us;
+    // 录制时pipeline的时钟差
+    int64_t time_diff_us;
+};
+
+struct IndexEntry {
+    uint64_t offset; // FrameHeader在文件中的偏移
+    uint64_t ltframe_id;
+    int64_t arrival_us;
+    uint32_t flags;
+};
+
+struct Trailer {
+    uint64_t index_offset;
+    uint32_t count;
+    uint32_t magic;
+};
+#pragma pack(pop)
+
+} // namespace stream_record
+
+// 把收到的编码帧连同元数据写进录制文件，用StreamReplayer离线回放.
+// record()只在调用线程拷贝一次数据，写文件在后台线程. 写不过来时丢帧计数，不阻塞调用者.
+// record()只能在一个线程调用(transport线程).
+class StreamRecorder {
+public:
+    struct Stat {
+        uint64_t recorded_frames;
+        uint64_t dropped_frames;
+        uint64_t bytes;
+    };
+
+public:
+    static std::unique_ptr<StreamRecorder> create(const std::string& path, VideoCodecType codec,
+                                                  uint32_t width, uint32_t height);
+    ~StreamRecorder();
+    void record(const lt::VideoFrame& frame, int64_t arrival_us, int64_t time_diff_us);
+    Stat getStat() const;
+
+private:
+    struct Entry {
+        stream_record::FrameHeader header;
+        FrameBufferPool::Buffer data;
+    };
+
+private:
+    StreamRecorder(std::FILE* file, const std::string& path);
+    void writeLoop(const std::function<void()>& i_am_alive);
+    bool writeEntry(Entry& entry);
+    void writeIndex();
+
+private:
+    // 积压超过这么多字节就丢帧，防止磁盘慢时把内存吃光
+    static constexpr uint64_t kMaxPendingBytes = 32 * 1024 * 1024;
+    const std::string path_;
+    std::FILE* file_;
+    // 必须声明在queue_之前，保证比队列里的buffer后析构
+    FrameBufferPool pool_;
+    ltlib::SpscQueue<Entry> queue_{256};
+    ltlib::EventCount event_;
+    std::atomic<bool> stoped_{false};
+    std::atomic<uint64_t> pending_bytes_{0};
+    std::atomic<uint64_t> recorded_frames_{0};
+    std::atomic<uint64_t> dropped_frames_{0};
+    std::atomic<uint64_t> bytes_{0};
+    // 只在写线程访问
+    uint64_t offset_ = 0;
+    bool write_failed_ = false;
+    std::vector<stream_record::IndexEntry> index_;
+    std::unique_ptr<ltlib::BlockingThread> thread_;
+};
+
+} // namespace lt
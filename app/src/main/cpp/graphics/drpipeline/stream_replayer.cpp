@@ -0,0 +1,180 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "stream_replayer.h"
+
+#include <sys/types.h>
+
+#include <thread>
+
+#include <ltlib/logging.h>
+#include <ltlib/times.h>
+
+// 录制文件很容易超过2GB，32位ABI上fseek的long只有32位
+static_assert(sizeof(off_t) >= 8, "Stream record needs 64-bit off_t, define _FILE_OFFSET_BITS=64");
+
+namespace {
+
+bool seekTo(std::FILE* file, int64_t offset, int whence) {
+    return fseeko(file, static_cast<off_t>(offset), whence) == 0;
+}
+
+} // namespace
+
+namespace lt {
+
+using namespace stream_record;
+
+std::unique_ptr<StreamReplayer> StreamReplayer::open(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        LOG(ERR) << "Open stream record file '" << path << "' failed";
+        return nullptr;
+    }
+    FileHeader header{};
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || header.magic != kFileMagic ||
+        header.version != kVersion) {
+        LOG(ERR) << "'" << path << "' is not a stream record file";
+        std::fclose(file);
+        return nullptr;
+    }
+    std::unique_ptr<StreamReplayer> replayer{new StreamReplayer{file, header}};
+    if (!replayer->loadIndex() && !replayer->scanIndex()) {
+        return nullptr;
+    }
+    LOG(INFO) << "Opened stream record '" << path << "' with " << replayer->frameCount()
+              << " frames";
+    return replayer;
+}
+
+StreamReplayer::StreamReplayer(std::FILE* file, const FileHeader& header)
+    : file_{file}
+    , header_{header} {}
+
+StreamReplayer::~StreamReplayer() {
+    std::fclose(file_);
+}
+
+VideoCodecType StreamReplayer::codec() const {
+    return static_cast<VideoCodecType>(header_.codec);
+}
+
+uint32_t StreamReplayer::width() const {
+    return header_.width;
+}
+
+uint32_t StreamReplayer::height() const {
+    return header_.height;
+}
+
+bool StreamReplayer::loadIndex() {
+    Trailer trailer{};
+    if (!seekTo(file_, -static_cast<int64_t>(sizeof(trailer)), SEEK_END) ||
+        std::fread(&trailer, sizeof(trailer), 1, file_) != 1 || trailer.magic != kIndexMagic) {
+        return false;
+    }
+    index_.resize(trailer.count);
+    if (!seekTo(file_, static_cast<int64_t>(trailer.index_offset), SEEK_SET) ||
+        (trailer.count != 0 &&
+         std::fread(index_.data(), sizeof(IndexEntry), index_.size(), file_) != index_.size())) {
+        index_.clear();
+        return false;
+    }
+    return true;
+}
+
+// 录制时没有正常关闭(比如进程被杀)，没有索引，从头扫一遍. 末尾写了一半的帧丢掉
+bool StreamReplayer::scanIndex() {
+    LOG(WARNING) << "Stream record has no index, scanning frames";
+    index_.clear();
+    uint64_t offset = sizeof(FileHeader);
+    FrameHeader header{};
+    while (seekTo(file_, static_cast<int64_t>(offset), SEEK_SET) &&
+           std::fread(&header, sizeof(header), 1, file_) == 1 && header.magic == kFrameMagic) {
+        if (!seekTo(file_, static_cast<int64_t>(header.size) - 1, SEEK_CUR) ||
+            std::fgetc(file_) == EOF) {
+            break;
+        }
+        index_.push_back(IndexEntry{offset, header.ltframe_id, header.arrival_us, header.flags});
+        offset += sizeof(header) + header.size;
+    }
+    return true;
+}
+
+StreamReplayer::Stat StreamReplayer::replay(Pacing pacing, const Sink& sink,
+                                            const std::atomic<bool>* stop) {
+    Stat stat{};
+    std::vector<uint8_t> data;
+    const int64_t start_us = ltlib::steady_now_us();
+    const int64_t first_arrival_us = index_.empty() ? 0 : index_.front().arrival_us;
+    for (const auto& entry : index_) {
+        if (stop != nullptr && stop->load(std::memory_order_relaxed)) {
+            break;
+        }
+        FrameHeader header{};
+        if (!seekTo(file_, static_cast<int64_t>(entry.offset), SEEK_SET) ||
+            std::fread(&header, sizeof(header), 1, file_) != 1 || header.magic != kFrameMagic) {
+            LOG(ERR) << "Read frame header at " << entry.offset << " failed";
+            break;
+        }
+        data.resize(header.size);
+        if (header.size != 0 && std::fread(data.data(), 1, header.size, file_) != header.size) {
+            LOG(ERR) << "Read frame " << header.ltframe_id << " failed";
+            break;
+        }
+        if (pacing == Pacing::Original) {
+            const int64_t due_us = start_us + header.arrival_us - first_arrival_us;
+            const int64_t wait_us = due_us - ltlib::steady_now_us();
+            if (wait_us > 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds{wait_us});
+            }
+        }
+        // 平移量 = 回放到达时刻 - 录制到达时刻，加在host时间戳上等于把整条链路搬到现在
+        const int64_t shift_us = ltlib::steady_now_us() - header.arrival_us;
+        lt::VideoFrame frame{};
+        frame.is_keyframe = (header.flags & kKeyframeFlag) != 0;
+        frame.ltframe_id = header.ltframe_id;
+        frame.data = data.data();
+        frame.size = header.size;
+        frame.width = header.width;
+        frame.height = header.height;
+        frame.capture_timestamp_us = header.capture_timestamp_us + shift_us;
+        frame.start_encode_timestamp_us = header.start_encode_timestamp_us + shift_us;
+        frame.end_encode_timestamp_us = header.end_encode_timestamp_us + shift_us;
+        sink(frame, header.time_diff_us);
+        stat.frames++;
+        stat.bytes += header.size;
+    }
+    stat.elapsed_us = ltlib::steady_now_us() - start_us;
+    LOG(INFO) << "Replayed " << stat.frames << " frames in " << stat.elapsed_us / 1000 << "ms";
+    return stat;
+}
+
+} // namespace lt
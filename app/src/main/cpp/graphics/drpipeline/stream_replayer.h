@@ -0,0 +1,88 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "stream_recorder.h"
+
+namespace lt {
+
+// 读取StreamRecorder的录制文件，把帧按原来的节奏或者尽快地交给sink，
+// 用来在本地复现现场的问题或者测量解码渲染的极限吞吐.
+class StreamReplayer {
+public:
+    enum class Pacing {
+        // 按录制时的到达间隔送帧
+        Original,
+        // 不等待，上一帧返回后马上送下一帧
+        MaxSpeed,
+    };
+
+    // time_diff_us是录制时的时钟差，变化时sink应该同步给pipeline
+    using Sink = std::function<void(const lt::VideoFrame& frame, int64_t time_diff_us)>;
+
+    struct Stat {
+        uint64_t frames;
+        uint64_t bytes;
+        int64_t elapsed_us;
+    };
+
+public:
+    static std::unique_ptr<StreamReplayer> open(const std::string& path);
+    ~StreamReplayer();
+    VideoCodecType codec() const;
+    uint32_t width() const;
+    uint32_t height() const;
+    size_t frameCount() const { return index_.size(); }
+
+    // 阻塞直到回放完或者stop为true. 时间戳整体平移到回放时刻，保持帧之间原有的间隔和网络时延,
+    // 这样pipeline的过期丢帧、平滑和延迟统计和录制时的行为一致
+    Stat replay(Pacing pacing, const Sink& sink, const std::atomic<bool>* stop = nullptr);
+
+private:
+    StreamReplayer(std::FILE* file, const stream_record::FileHeader& header);
+    bool loadIndex();
+    bool scanIndex();
+
+private:
+    std::FILE* file_;
+    const stream_record::FileHeader header_;
+    std::vector<stream_record::IndexEntry> index_;
+};
+
+} // namespace lt
@@ -30,21 +30,32 @@
 
 #include "video_decode_render_pipeline.h"
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
-#include <fstream>
+#include <array>
 #include <mutex>
+#include <optional>
 #include <tuple>
 
 #include <ltlib/logging.h>
 
-// #include <ltproto/ltproto.h>
-// #include <ltproto/worker2service/reconfigure_video_encoder.pb.h>
+#include <ltproto/ltproto.h>
+#include <ltproto/worker2service/reconfigure_video_encoder.pb.h>
 
+#include <ltlib/event_count.h>
+#include <ltlib/spsc_queue.h>
 #include <ltlib/threads.h>
 #include <ltlib/times.h>
+#include <ltlib/trace.h>
 
 #include "ct_smoother.h"
+#include "frame_buffer_pool.h"
+#include "frame_latency_tracer.h"
+#include "quality_controller.h"
+#include "receive_side_stat.h"
+#include "stream_recorder.h"
+#include "vsync_source.h"
 #include <graphics/decoder/video_decoder.h>
 #include <graphics/drpipeline/video_statistics.h>
 #include <graphics/renderer/video_renderer.h>
@@ -58,8 +69,13 @@ using namespace std::chrono_literals;
 
 class VDRPipeline {
 public:
+    // data指向decoder_input或data_internal二者之一
     struct VideoFrameInternal : lt::VideoFrame {
-        std::shared_ptr<uint8_t> data_internal;
+        bool render = true;
+        // 本地收到这一帧的时间
+        int64_t arrival_us = 0;
+        std::optional<DecoderInputBuffer> decoder_input;
+        FrameBufferPool::Buffer data_internal;
     };
 
 public:
@@ -78,21 +94,41 @@ public:
 
 private:
     void decodeLoop(const std::function<void()>& i_am_alive);
+    void decodeLoopAsync(const std::function<void()>& i_am_alive);
+    void onFrameDecoded(const DecodedFrame& decoded_frame, int64_t capture_time_us,
+                        int64_t decode_time_us);
     void renderLoop(const std::function<void()>& i_am_alive);
+    static VideoFrameInternal copyFrameInfo(const lt::VideoFrame& frame);
+    int64_t traceArrival(const lt::VideoFrame& frame);
+    bool writeToDecoderInput(const lt::VideoFrame& src, VideoFrameInternal& frame);
+    VideoDecodeRenderPipeline::Action enqueue(VideoFrameInternal frame);
+    DecodedFrame decodeOne(VideoFrameInternal& frame);
+    void releaseFrame(VideoFrameInternal& frame);
+    size_t dropStaleFrames(std::vector<VideoFrameInternal>& frames, size_t begin);
+    bool isStale(const VideoFrameInternal& frame, int64_t now_us) const;
 
     bool waitForDecode(std::vector<VideoFrameInternal>& frames,
                        std::chrono::microseconds max_delay);
-    bool waitForRender(std::chrono::microseconds ms);
+    void popEncodedFrames(std::vector<VideoFrameInternal>& frames);
     void onStat();
-    // void onUserSetBitrate(uint32_t bps);
+    void sendReconfigure(const QualityController::Target& target);
+    void onUserSetBitrate(uint32_t bps);
     std::tuple<int32_t, float, float> getCursorInfo();
     bool isAbsoluteMouse();
 
 private:
+    // 120fps下约半秒的积压，再多也没有意义，不如丢掉等关键帧
+    static constexpr size_t kMaxEncodedFrames = 64;
+    static constexpr int64_t kStatPeriodMs = 1000;
+    static constexpr int kDisplayNice = -4;
+    static constexpr int kUrgentDisplayNice = -8;
     const uint32_t width_;
     const uint32_t height_;
     const uint32_t screen_refresh_rate_;
     const lt::VideoCodecType codec_type_;
+    const bool async_decode_;
+    const int64_t max_queue_age_us_;
+    const std::string record_path_;
     std::function<void(uint32_t, std::shared_ptr<google::protobuf::MessageLite>, bool)>
         send_message_to_host_;
     // NOTE: 安卓在video模块上不使用SDL
@@ -100,19 +136,28 @@ private:
     jobject window_;
 
     std::atomic<bool> request_i_frame_ = false;
-    std::vector<VideoFrameInternal> encoded_frames_;
-
-    bool decode_signal_ = false;
-    std::mutex decode_mtx_;
-    std::condition_variable waiting_for_decode_;
+    // 必须声明在encoded_frames_之前，保证比所有租出去的buffer后析构
+    FrameBufferPool frame_pool_;
+    // 异步解码时，帧送进解码器后只剩ltframe_id，靠它找回采集时间
+    std::array<int64_t, kMaxEncodedFrames> capture_times_{};
+    // 生产者是transport线程(submit)，消费者是解码线程
+    ltlib::SpscQueue<VideoFrameInternal> encoded_frames_{kMaxEncodedFrames};
+    ltlib::EventCount decode_event_;
+    // 队列满时丢帧，之后的帧都丢掉直到下一个关键帧. 只在submit线程访问
+    bool waiting_for_keyframe_ = false;
+    // 队列中没有写进解码器输入缓冲区的帧数. 不为0时新来的帧也不能占用解码器的输入缓冲区,
+    // 否则排在前面的帧可能永远等不到空闲的输入缓冲区
+    std::atomic<uint32_t> pending_copied_frames_{0};
 
     bool render_signal_ = false;
     std::mutex render_mtx_;
-    std::condition_variable waiting_for_render_;
 
     std::unique_ptr<VideoRenderer> video_renderer_;
     std::unique_ptr<VideoDecoder> video_decoder_;
     CTSmoother smoother_;
+    FrameLatencyTracer latency_tracer_;
+    std::unique_ptr<StreamRecorder> recorder_;
+    std::unique_ptr<VsyncSource> vsync_;
     std::atomic<bool> stoped_{true};
     std::unique_ptr<ltlib::BlockingThread> decode_thread_;
     std::unique_ptr<ltlib::BlockingThread> render_thread_;
@@ -121,12 +166,18 @@ private:
     bool show_status_ = true;
     std::unique_ptr<WidgetsManager> widgets_;
     std::unique_ptr<VideoStatistics> statistics_;
-    std::unique_ptr<ltlib::TaskThread> stat_thread_;
+    std::unique_ptr<ltlib::Strand> stat_strand_;
     int64_t time_diff_ = 0;
     int64_t rtt_ = 0;
-    uint32_t bwe_ = 0;
-    uint32_t nack_ = 0;
-    float loss_rate_ = .0f;
+    // 以下三个由host的SendSideStat更新，在统计线程读取
+    std::atomic<uint32_t> bwe_{0};
+    std::atomic<uint32_t> nack_{0};
+    std::atomic<float> loss_rate_{.0f};
+    std::optional<VideoStatistics::Stat> last_stat_;
+    // 只在统计线程访问
+    QualityController quality_;
+    // 最近一次发给host的码率和帧率，0表示还没发过，只在统计线程访问
+    QualityController::Target sent_target_;
 
     int32_t cursor_id_ = 0;
     float cursor_x_ = 0.f;
@@ -140,16 +191,27 @@ VDRPipeline::VDRPipeline(const VideoDecodeRenderPipeline::Params& params)
     , height_{params.height}
     , screen_refresh_rate_{params.screen_refresh_rate}
     , codec_type_{params.codec_type}
+    , async_decode_{params.async_decode}
+    , max_queue_age_us_{static_cast<int64_t>(params.max_queue_age_ms) * 1000}
+    , record_path_{params.record_path}
     , send_message_to_host_{params.send_message_to_host}
     , window_{params.video_surface}
-    , statistics_{new VideoStatistics} {}
+    , smoother_{params.smooth_playback ? CTSmoother::Mode::Smooth : CTSmoother::Mode::LowLatency}
+    , statistics_{new VideoStatistics}
+    , quality_{QualityController::Params{params.screen_refresh_rate}} {}
 
 VDRPipeline::~VDRPipeline() {
     stoped_ = true;
+    stat_strand_.reset();
+    decode_event_.notify();
     decode_thread_.reset();
     render_thread_.reset();
     video_decoder_.reset();
     video_renderer_.reset();
+    LOG(INFO) << latency_tracer_.summary();
+    auto pool_stat = frame_pool_.getStat();
+    LOG(INFO) << "FrameBufferPool hits:" << pool_stat.hits << ", misses:" << pool_stat.misses
+              << ", high_water:" << pool_stat.high_water;
     JNIEnv* env = nullptr;
     g_jvm->GetEnv((void**)&env, JNI_VERSION_1_6);
     env->DeleteGlobalRef(window_);
@@ -199,10 +261,14 @@ bool VDRPipeline::init() {
 #endif
     decode_params.width = width_;
     decode_params.height = height_;
+    decode_params.async = async_decode_;
     video_decoder_ = VideoDecoder::create(decode_params);
     if (video_decoder_ == nullptr) {
         return false;
     }
+    if (video_decoder_->isAsync()) {
+        video_decoder_->setNotifier([this]() { decode_event_.notify(); });
+    }
     if (!video_renderer_->bindTextures(video_decoder_->textures())) {
         return false;
     }
@@ -212,45 +278,70 @@ bool VDRPipeline::init() {
     widgets_params.window = window_;
     widgets_params.video_width = width_;
     widgets_params.video_height = height_;
-    widgets_params.set_bitrate = [](uint32_t) {};
+    widgets_params.set_bitrate =
+        std::bind(&VDRPipeline::onUserSetBitrate, this, std::placeholders::_1);
     widgets_ = WidgetsManager::create(widgets_params);
     if (widgets_ == nullptr) {
         return false;
     }
+    vsync_ = VsyncSource::create(screen_refresh_rate_);
+    if (!record_path_.empty()) {
+        // 录制失败不影响正常播放
+        recorder_ = StreamRecorder::create(record_path_, codec_type_, width_, height_);
+    }
     smoother_.clear();
     stoped_ = false;
+    // nice值取自android.os.Process的THREAD_PRIORITY_DISPLAY/URGENT_DISPLAY.
+    // 渲染线程落到小核上经常赶不上vsync，两个线程都放到大核
+    ltlib::ThreadOptions decode_options;
+    decode_options.priority = kDisplayNice;
+    decode_options.cores = ltlib::ThreadOptions::Cores::Big;
+    ltlib::ThreadOptions render_options;
+    render_options.priority = kUrgentDisplayNice;
+    render_options.cores = ltlib::ThreadOptions::Cores::Big;
     decode_thread_ = ltlib::BlockingThread::create(
         "video_decode",
-        [this](const std::function<void()>& i_am_alive) { decodeLoop(i_am_alive); });
+        [this](const std::function<void()>& i_am_alive) { decodeLoop(i_am_alive); },
+        decode_options);
     render_thread_ = ltlib::BlockingThread::create(
         "video_render",
-        [this](const std::function<void()>& i_am_alive) { renderLoop(i_am_alive); });
-    //    stat_thread_ = ltlib::TaskThread::create("stat_task");
-    //    stat_thread_->post_delay(ltlib::TimeDelta{1'000'00}, std::bind(&VDRPipeline::onStat,
-    //    this));
+        [this](const std::function<void()>& i_am_alive) { renderLoop(i_am_alive); },
+        render_options);
+    // 每秒只跑一次，不单独占线程
+    stat_strand_ = ltlib::Strand::create(ltlib::Executor::shared(), "video_stat");
+    stat_strand_->post_delay(ltlib::TimeDelta{kStatPeriodMs * 1000},
+                             std::bind(&VDRPipeline::onStat, this));
     return true;
 }
 
 VideoDecodeRenderPipeline::Action VDRPipeline::submit(const lt::VideoFrame& _frame) {
-    // static std::fstream stream{"./vidoe_stream",
-    //                            std::ios::out | std::ios::binary | std::ios::trunc};
-    // stream.write(reinterpret_cast<const char*>(_frame.data), _frame.size);
-    // stream.flush();
-    LOGF(DEBUG, "capture:%" PRId64 ", start_enc:% " PRId64 ", end_enc:%" PRId64,
-         _frame.capture_timestamp_us, _frame.start_encode_timestamp_us,
-         _frame.end_encode_timestamp_us);
-    if (_frame.is_keyframe) {
-        LOG(DEBUG) << "Received key frame size " << _frame.size;
+    const int64_t arrival_us = traceArrival(_frame);
+    VideoFrameInternal frame = copyFrameInfo(_frame);
+    frame.arrival_us = arrival_us;
+    if (!writeToDecoderInput(_frame, frame)) {
+        frame.data_internal = frame_pool_.acquire(_frame.size);
+        memcpy(frame.data_internal.data(), _frame.data, _frame.size);
+        frame.data = frame.data_internal.data();
     }
-    statistics_->addEncode();
-    statistics_->updateVideoBW(_frame.size);
-    statistics_->updateEncodeTime(_frame.end_encode_timestamp_us -
-                                  _frame.start_encode_timestamp_us);
-    if (time_diff_ != 0) {
-        statistics_->updateNetDelay(ltlib::steady_now_us() - _frame.end_encode_timestamp_us -
-                                    time_diff_);
+    return enqueue(std::move(frame));
+}
+
+int64_t VDRPipeline::traceArrival(const lt::VideoFrame& frame) {
+    LT_TRACE_FLOW_BEGIN("frame", frame.ltframe_id);
+    // 对端的时间换算到本地时基，还没同步时钟时不记
+    const int64_t diff = time_diff_;
+    auto to_local = [diff](int64_t remote_us) { return diff == 0 ? 0 : remote_us + diff; };
+    const int64_t arrival_us = ltlib::steady_now_us();
+    latency_tracer_.begin(frame.ltframe_id, to_local(frame.capture_timestamp_us),
+                          to_local(frame.start_encode_timestamp_us),
+                          to_local(frame.end_encode_timestamp_us), arrival_us);
+    if (recorder_ != nullptr) {
+        recorder_->record(frame, arrival_us, diff);
     }
+    return arrival_us;
+}
 
+VDRPipeline::VideoFrameInternal VDRPipeline::copyFrameInfo(const lt::VideoFrame& _frame) {
     VideoFrameInternal frame{};
     frame.is_keyframe = _frame.is_keyframe;
     frame.ltframe_id = _frame.ltframe_id;
@@ -260,15 +351,59 @@ VideoDecodeRenderPipeline::Action VDRPipeline::submit(const lt::VideoFrame& _fra
     frame.capture_timestamp_us = _frame.capture_timestamp_us;
     frame.start_encode_timestamp_us = _frame.start_encode_timestamp_us;
     frame.end_encode_timestamp_us = _frame.end_encode_timestamp_us;
-    frame.data_internal = std::shared_ptr<uint8_t>(new uint8_t[_frame.size]);
-    memcpy(frame.data_internal.get(), _frame.data, _frame.size);
-    frame.data = frame.data_internal.get();
-    {
-        std::unique_lock<std::mutex> lock(decode_mtx_);
-        encoded_frames_.emplace_back(frame);
-        decode_signal_ = true;
+    return frame;
+}
+
+bool VDRPipeline::writeToDecoderInput(const lt::VideoFrame& src, VideoFrameInternal& frame) {
+    if (pending_copied_frames_.load() != 0) {
+        return false;
+    }
+    auto input = video_decoder_->acquireInputBuffer(src.size);
+    if (!input.has_value()) {
+        return false;
+    }
+    memcpy(input->data, src.data, src.size);
+    frame.data = input->data;
+    frame.decoder_input = input;
+    return true;
+}
+
+VideoDecodeRenderPipeline::Action VDRPipeline::enqueue(VideoFrameInternal frame) {
+    LOGF(DEBUG, "capture:%" PRId64 ", start_enc:% " PRId64 ", end_enc:%" PRId64,
+         frame.capture_timestamp_us, frame.start_encode_timestamp_us,
+         frame.end_encode_timestamp_us);
+    if (frame.is_keyframe) {
+        LOG(DEBUG) << "Received key frame size " << frame.size;
+    }
+    statistics_->addEncode();
+    statistics_->updateVideoBW(frame.size);
+    statistics_->updateEncodeTime(frame.end_encode_timestamp_us -
+                                  frame.start_encode_timestamp_us);
+    if (time_diff_ != 0) {
+        statistics_->updateNetDelay(ltlib::steady_now_us() - frame.end_encode_timestamp_us -
+                                    time_diff_);
+    }
+    if (!frame.decoder_input.has_value()) {
+        pending_copied_frames_++;
+    }
+    if (waiting_for_keyframe_ && !frame.is_keyframe) {
+        releaseFrame(frame);
+        return VideoDecodeRenderPipeline::Action::NONE;
+    }
+    waiting_for_keyframe_ = false;
+    const uint64_t ltframe_id = frame.ltframe_id;
+    if (encoded_frames_.try_push(std::move(frame))) {
+        latency_tracer_.mark(ltframe_id, FrameLatencyTracer::Stage::Enqueue,
+                             ltlib::steady_now_us());
+        decode_event_.notify();
+    }
+    else {
+        // try_push失败不会移走frame
+        LOG(WARNING) << "Too many frames waiting for decode, drop until next key frame";
+        releaseFrame(frame);
+        waiting_for_keyframe_ = true;
+        request_i_frame_ = true;
     }
-    waiting_for_decode_.notify_one();
     bool request_i_frame = request_i_frame_.exchange(false);
     return request_i_frame ? VideoDecodeRenderPipeline::Action::REQUEST_KEY_FRAME
                            : VideoDecodeRenderPipeline::Action::NONE;
@@ -294,6 +429,7 @@ void VDRPipeline::setNack(uint32_t nack) {
 
 void VDRPipeline::setLossRate(float rate) {
     loss_rate_ = rate;
+    statistics_->updateLossRate(rate);
 }
 
 void VDRPipeline::resetRenderTarget() {
@@ -315,61 +451,240 @@ void VDRPipeline::switchMouseMode(bool absolute) {
 
 bool VDRPipeline::waitForDecode(std::vector<VideoFrameInternal>& frames,
                                 std::chrono::microseconds max_delay) {
-    std::unique_lock<std::mutex> lock(decode_mtx_);
-    if (encoded_frames_.empty()) {
-        waiting_for_decode_.wait_for(lock, max_delay, [this]() { return decode_signal_; });
-        decode_signal_ = false;
+    popEncodedFrames(frames);
+    if (!frames.empty()) {
+        return true;
+    }
+    auto key = decode_event_.prepare_wait();
+    if (!encoded_frames_.empty() || stoped_) {
+        decode_event_.cancel_wait();
+    }
+    else {
+        decode_event_.wait_for(key, max_delay);
     }
-    frames.swap(encoded_frames_);
+    popEncodedFrames(frames);
     return !frames.empty();
 }
 
+void VDRPipeline::popEncodedFrames(std::vector<VideoFrameInternal>& frames) {
+    VideoFrameInternal frame;
+    while (encoded_frames_.try_pop(frame)) {
+        frames.push_back(std::move(frame));
+    }
+}
+
 void VDRPipeline::decodeLoop(const std::function<void()>& i_am_alive) {
+    if (video_decoder_->isAsync()) {
+        decodeLoopAsync(i_am_alive);
+        return;
+    }
+    // 复用同一个vector，避免每轮循环都分配内存
+    std::vector<VideoFrameInternal> frames;
+    frames.reserve(kMaxEncodedFrames);
     while (!stoped_) {
         i_am_alive();
-        std::vector<VideoFrameInternal> frames;
-        waitForDecode(frames, 5ms);
+        frames.clear();
+        // 有新帧时submit会立即唤醒，这里的超时只是为了定期检查stoped_和上报心跳
+        waitForDecode(frames, 100ms);
         if (frames.empty()) {
             continue;
         }
-        for (auto& frame : frames) {
+        LT_TRACE_COUNTER("decode_queue", frames.size());
+        size_t begin = dropStaleFrames(frames, 0);
+        for (size_t i = begin; i < frames.size(); i++) {
+            auto& frame = frames[i];
+            LT_TRACE_SCOPE("decode");
+            LT_TRACE_FLOW_STEP("frame", frame.ltframe_id);
             auto start = ltlib::steady_now_us();
-            DecodedFrame decoded_frame = video_decoder_->decode(frame.data, frame.size);
+            latency_tracer_.mark(frame.ltframe_id, FrameLatencyTracer::Stage::DecodeStart, start);
+            video_decoder_->setRenderOutput(frame.render);
+            DecodedFrame decoded_frame = decodeOne(frame);
             auto end = ltlib::steady_now_us();
+            decoded_frame.ltframe_id = static_cast<int64_t>(frame.ltframe_id);
             if (decoded_frame.status == DecodeStatus::Failed) {
                 LOG(ERR) << "Failed to call decode(), reqesut i frame";
                 request_i_frame_ = true;
+                for (size_t j = i + 1; j < frames.size(); j++) {
+                    releaseFrame(frames[j]);
+                }
                 break;
             }
             else if (decoded_frame.status == DecodeStatus::EAgain) {
                 LOG(FATAL) << "Should not be reach here";
             }
+            else if (frame.render) {
+                onFrameDecoded(decoded_frame, frame.capture_timestamp_us, end - start);
+            }
             else {
-                LOG(DEBUG) << "CAPTURE-AFTER_DECODE "
-                           << ltlib::steady_now_us() - frame.capture_timestamp_us - time_diff_;
                 statistics_->updateDecodeTime(end - start);
-                CTSmoother::Frame f;
-                f.no = decoded_frame.frame;
-                f.capture_time = frame.capture_timestamp_us;
-                f.at_time = ltlib::steady_now_us();
-                {
-                    std::unique_lock<std::mutex> lock(render_mtx_);
-                    smoother_.push(f);
+            }
+        }
+    }
+}
+
+void VDRPipeline::decodeLoopAsync(const std::function<void()>& i_am_alive) {
+    // frames[next]之前的帧已经送进解码器，之后的还在等空闲的输入缓冲区
+    std::vector<VideoFrameInternal> frames;
+    frames.reserve(kMaxEncodedFrames);
+    size_t next = 0;
+    while (!stoped_) {
+        i_am_alive();
+        // 先登记等待再检查，期间submit或解码器的通知都不会丢
+        auto key = decode_event_.prepare_wait();
+        if (next == frames.size()) {
+            frames.clear();
+            next = 0;
+        }
+        size_t old_size = frames.size();
+        popEncodedFrames(frames);
+        bool progress = frames.size() != old_size;
+        next = dropStaleFrames(frames, next);
+        LT_TRACE_COUNTER("decode_queue", frames.size() - next);
+        while (next < frames.size()) {
+            auto& frame = frames[next];
+            LT_TRACE_SCOPE("submit_to_decoder");
+            LT_TRACE_FLOW_STEP("frame", frame.ltframe_id);
+            video_decoder_->setRenderOutput(frame.render);
+            latency_tracer_.mark(frame.ltframe_id, FrameLatencyTracer::Stage::DecodeStart,
+                                 ltlib::steady_now_us());
+            DecodeStatus status =
+                video_decoder_->submitFrame(frame.data, frame.size, frame.ltframe_id);
+            if (status == DecodeStatus::EAgain) {
+                break;
+            }
+            progress = true;
+            if (status == DecodeStatus::Failed) {
+                LOG(ERR) << "Failed to call submitFrame(), reqesut i frame";
+                request_i_frame_ = true;
+                for (; next < frames.size(); next++) {
+                    releaseFrame(frames[next]);
+                }
+                break;
+            }
+            capture_times_[frame.ltframe_id % capture_times_.size()] =
+                frame.capture_timestamp_us;
+            releaseFrame(frame);
+            next++;
+        }
+        while (auto decoded_frame = video_decoder_->pollFrame()) {
+            LT_TRACE_SCOPE("decoder_output");
+            if (decoded_frame->ltframe_id >= 0) {
+                LT_TRACE_FLOW_STEP("frame", decoded_frame->ltframe_id);
+            }
+            progress = true;
+            if (decoded_frame->status == DecodeStatus::Failed) {
+                // TODO: 更好地通知退出
+                LOG(ERR) << "Async video decoder failed, exit decode loop";
+                return;
+            }
+            int64_t capture_time = 0;
+            if (decoded_frame->ltframe_id >= 0) {
+                capture_time = capture_times_[decoded_frame->ltframe_id % capture_times_.size()];
+            }
+            if (decoded_frame->render) {
+                onFrameDecoded(decoded_frame.value(), capture_time, decoded_frame->decode_time_us);
+            }
+            else {
+                statistics_->updateDecodeTime(decoded_frame->decode_time_us);
+            }
+        }
+        if (progress) {
+            decode_event_.cancel_wait();
+        }
+        else {
+            decode_event_.wait_for(key, 100ms);
+        }
+    }
+}
+
+void VDRPipeline::onFrameDecoded(const DecodedFrame& decoded_frame, int64_t capture_time_us,
+                                 int64_t decode_time_us) {
+    statistics_->updateDecodeTime(decode_time_us);
+    CTSmoother::Frame f;
+    f.no = decoded_frame.frame;
+    f.ltframe_id = decoded_frame.ltframe_id;
+    f.capture_time = capture_time_us;
+    f.at_time = ltlib::steady_now_us();
+    if (f.ltframe_id >= 0) {
+        latency_tracer_.mark(f.ltframe_id, FrameLatencyTracer::Stage::DecodeEnd, f.at_time);
+    }
+    {
+        std::unique_lock<std::mutex> lock(render_mtx_);
+        smoother_.push(f);
+    }
+}
+
+DecodedFrame VDRPipeline::decodeOne(VideoFrameInternal& frame) {
+    DecodedFrame decoded_frame{};
+    if (frame.decoder_input.has_value()) {
+        decoded_frame = video_decoder_->commitInputBuffer(frame.decoder_input.value(), frame.size);
+        frame.decoder_input.reset();
+    }
+    else {
+        decoded_frame = video_decoder_->decode(frame.data, frame.size);
+        pending_copied_frames_--;
+    }
+    // 解码器已经把数据拷走，尽早归还内存
+    frame.data_internal.reset();
+    return decoded_frame;
+}
+
+// 处理frames[begin..]中排队太久的帧，返回第一个需要解码的帧的下标
+size_t VDRPipeline::dropStaleFrames(std::vector<VideoFrameInternal>& frames, size_t begin) {
+    if (max_queue_age_us_ == 0 || begin >= frames.size()) {
+        return begin;
+    }
+    int64_t now = ltlib::steady_now_us();
+    const size_t last = frames.size() - 1;
+    if (isStale(frames[begin], now)) {
+        // 后面排着关键帧，它之前的帧解不解都一样
+        for (size_t i = last; i > begin; i--) {
+            if (frames[i].is_keyframe) {
+                for (size_t j = begin; j < i; j++) {
+                    releaseFrame(frames[j]);
                 }
-                waiting_for_render_.notify_one();
+                LOG(INFO) << "Skip " << i - begin << " stale frames to next key frame";
+                statistics_->addDroppedFrames(static_cast<uint32_t>(i - begin));
+                begin = i;
+                break;
             }
         }
     }
+    // 没有关键帧可跳，过期的帧只解码不显示，但最新的一帧总要显示
+    uint32_t no_render = 0;
+    for (size_t i = begin; i < last; i++) {
+        if (frames[i].render && isStale(frames[i], now)) {
+            frames[i].render = false;
+            no_render++;
+        }
+    }
+    if (no_render > 0) {
+        statistics_->addDroppedFrames(no_render);
+    }
+    return begin;
+}
+
+bool VDRPipeline::isStale(const VideoFrameInternal& frame, int64_t now_us) const {
+    // 从本地收到算起，只算在本机排队的时间. 网络和编码的延迟不归这里管，
+    // 从采集算起的话，单向延迟接近max_queue_age_ms的链路上每一帧都会被丢掉
+    return now_us - frame.arrival_us > max_queue_age_us_;
 }
 
-bool VDRPipeline::waitForRender(std::chrono::microseconds ms) {
-    std::unique_lock<std::mutex> lock(render_mtx_);
-    bool ret = waiting_for_render_.wait_for(lock, ms, [this]() { return smoother_.size() > 0; });
-    return ret;
+// 归还帧占用的内存或解码器输入缓冲区
+void VDRPipeline::releaseFrame(VideoFrameInternal& frame) {
+    if (frame.decoder_input.has_value()) {
+        video_decoder_->commitInputBuffer(frame.decoder_input.value(), 0);
+        frame.decoder_input.reset();
+    }
+    else {
+        pending_copied_frames_--;
+    }
+    frame.data_internal.reset();
 }
 
 void VDRPipeline::onStat() {
     auto stat = statistics_->getStat();
+    LOG(DEBUG) << latency_tracer_.summary();
     if (show_statistics_) {
         // widgets_->updateStatistics(stat);
     }
@@ -377,7 +692,70 @@ void VDRPipeline::onStat() {
         // widgets_->updateStatus((uint32_t)rtt_ / 1000, (uint32_t)stat.render_video_fps,
         // loss_rate_);
     }
-    stat_thread_->post_delay(ltlib::TimeDelta{1'000'00}, std::bind(&VDRPipeline::onStat, this));
+    const VideoStatistics::Stat* prev = last_stat_.has_value() ? &last_stat_.value() : nullptr;
+    auto report = ReceiveSideStat::fromStat(stat, prev, kStatPeriodMs);
+    // SpscQueue::size()在其它线程读可能短暂地不准，限制在容量内
+    report.decode_queue_depth =
+        static_cast<uint32_t>(std::min(encoded_frames_.size(), encoded_frames_.capacity()));
+    report.decoder_in_flight = video_decoder_->framesInFlight();
+    report.render_queue_depth = static_cast<uint32_t>(smoother_.size());
+    report.jitter_us = static_cast<uint32_t>(smoother_.jitterUs());
+    report.jitter_buffer_us = static_cast<uint32_t>(smoother_.targetDelayUs());
+    report.nack = nack_;
+    LOG(DEBUG) << report.toString();
+    if (auto target = quality_.update(report, bwe_); target.has_value()) {
+        sendReconfigure(target.value());
+    }
+    last_stat_ = std::move(stat);
+    stat_strand_->post_delay(ltlib::TimeDelta{kStatPeriodMs * 1000},
+                             std::bind(&VDRPipeline::onStat, this));
+}
+
+void VDRPipeline::sendReconfigure(const QualityController::Target& target) {
+    auto msg = std::make_shared<ltproto::worker2service::ReconfigureVideoEncoder>();
+    // 带上当前的自动/手动状态，否则host可能把用户手动设置的码率改回自动模式
+    const bool auto_bitrate = quality_.isAutoBitrate();
+    msg->set_trigger(auto_bitrate
+                         ? ltproto::worker2service::ReconfigureVideoEncoder_Trigger_TurnOnAuto
+                         : ltproto::worker2service::ReconfigureVideoEncoder_Trigger_TurnOffAuto);
+    // 只发有变化的字段. 用户固定了码率时，码率以用户的为准
+    bool changed = false;
+    if (auto_bitrate && target.bitrate_bps != sent_target_.bitrate_bps) {
+        msg->set_bitrate_bps(target.bitrate_bps);
+        sent_target_.bitrate_bps = target.bitrate_bps;
+        changed = true;
+    }
+    if (target.fps != sent_target_.fps) {
+        msg->set_fps(target.fps);
+        sent_target_.fps = target.fps;
+        changed = true;
+    }
+    if (!changed) {
+        return;
+    }
+    LOG(INFO) << "Reconfigure video encoder " << target.toString();
+    send_message_to_host_(ltproto::id(msg), msg, true);
+}
+
+// 界面线程调用，转到统计线程处理，避免和自适应控制抢状态
+void VDRPipeline::onUserSetBitrate(uint32_t bps) {
+    if (stat_strand_ == nullptr) {
+        return;
+    }
+    stat_strand_->post([this, bps]() {
+        quality_.setUserBitrate(bps);
+        auto msg = std::make_shared<ltproto::worker2service::ReconfigureVideoEncoder>();
+        if (bps == 0) {
+            msg->set_trigger(ltproto::worker2service::ReconfigureVideoEncoder_Trigger_TurnOnAuto);
+        }
+        else {
+            msg->set_trigger(ltproto::worker2service::ReconfigureVideoEncoder_Trigger_TurnOffAuto);
+            msg->set_bitrate_bps(bps);
+        }
+        // 回到自动模式后host用自己的码率，下次自动调整要重新发
+        sent_target_.bitrate_bps = bps;
+        send_message_to_host_(ltproto::id(msg), msg, true);
+    });
 }
 
 std::tuple<int32_t, float, float> VDRPipeline::getCursorInfo() {
@@ -391,41 +769,70 @@ bool VDRPipeline::isAbsoluteMouse() {
 }
 
 void VDRPipeline::renderLoop(const std::function<void()>& i_am_alive) {
+    const int64_t period_us = vsync_->periodUs();
+    int64_t last_vsync_us = 0;
     while (!stoped_) {
         i_am_alive();
-        ltlib::Timestamp cur_time = ltlib::Timestamp::now();
-        if (video_renderer_->waitForPipeline(16) && waitForRender(2ms)) {
-            auto frame = smoother_.get(cur_time.microseconds());
-            smoother_.pop();
-            video_renderer_->switchMouseMode(isAbsoluteMouse());
-            if (frame.has_value()) {
-                auto [cursor, x, y] = getCursorInfo();
-                video_renderer_->updateCursor(cursor, x, y, visible_);
-                LOG(DEBUG) << "CAPTURE-BEFORE_RENDER "
-                           << ltlib::steady_now_us() - frame->capture_time - time_diff_;
-                statistics_->addRenderVideo();
-                auto start = ltlib::steady_now_us();
-                auto result = video_renderer_->render(frame->no);
-                auto end = ltlib::steady_now_us();
-                switch (result) {
-                case VideoRenderer::RenderResult::Failed:
-                    // TODO: 更好地通知退出
-                    LOG(ERR) << "Render failed, exit render loop";
-                    return;
-                case VideoRenderer::RenderResult::Reset:
-                    widgets_->reset();
-                    break;
-                case VideoRenderer::RenderResult::Success2:
-                default:
-                    break;
-                }
-                statistics_->updateRenderVideoTime(end - start);
+        auto vsync_us = vsync_->waitForVsync(100ms);
+        if (!vsync_us.has_value()) {
+            continue;
+        }
+        // 每个vsync都会等，间隔超过一个周期说明上一轮渲染没赶上
+        if (last_vsync_us != 0) {
+            int64_t missed = (vsync_us.value() - last_vsync_us + period_us / 2) / period_us - 1;
+            if (missed > 0) {
+                statistics_->addMissedVsyncs(static_cast<uint32_t>(missed));
             }
+        }
+        last_vsync_us = vsync_us.value();
+        // 到下一个vsync为止该显示的帧，都在这个vsync显示
+        auto frame = smoother_.take(vsync_us.value() + period_us);
+        if (uint32_t dropped = smoother_.takeDroppedFrames(); dropped > 0) {
+            statistics_->addDroppedFrames(dropped);
+        }
+        if (!frame.has_value()) {
+            continue;
+        }
+        LT_TRACE_SCOPE("render");
+        if (frame->ltframe_id >= 0) {
+            LT_TRACE_FLOW_END("frame", frame->ltframe_id);
+        }
+        LT_TRACE_COUNTER("render_queue", smoother_.size());
+        if (video_renderer_->waitForPipeline(16)) {
+            video_renderer_->switchMouseMode(isAbsoluteMouse());
+            auto [cursor, x, y] = getCursorInfo();
+            video_renderer_->updateCursor(cursor, x, y, visible_);
+            statistics_->addRenderVideo();
             auto start = ltlib::steady_now_us();
+            if (frame->ltframe_id >= 0) {
+                latency_tracer_.mark(frame->ltframe_id, FrameLatencyTracer::Stage::Render, start);
+            }
+            auto result = video_renderer_->render(frame->no);
+            auto end = ltlib::steady_now_us();
+            switch (result) {
+            case VideoRenderer::RenderResult::Failed:
+                // TODO: 更好地通知退出
+                LOG(ERR) << "Render failed, exit render loop";
+                return;
+            case VideoRenderer::RenderResult::Reset:
+                widgets_->reset();
+                break;
+            case VideoRenderer::RenderResult::Success2:
+            default:
+                break;
+            }
+            statistics_->updateRenderVideoTime(end - start);
+            start = ltlib::steady_now_us();
             widgets_->render();
             auto mid = ltlib::steady_now_us();
-            video_renderer_->present();
-            auto end = ltlib::steady_now_us();
+            {
+                LT_TRACE_SCOPE("present");
+                video_renderer_->present();
+            }
+            end = ltlib::steady_now_us();
+            if (frame->ltframe_id >= 0) {
+                latency_tracer_.finish(frame->ltframe_id, end);
+            }
             statistics_->addPresent();
             statistics_->updateRenderWidgetsTime(mid - start);
             statistics_->updatePresentTime(end - mid);
@@ -32,6 +32,7 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
 
 #include <jni.h>
 
@@ -61,6 +62,15 @@ public:
         jobject video_surface;
         std::function<void(uint32_t, std::shared_ptr<google::protobuf::MessageLite>, bool)>
             send_message_to_host;
+        // 多帧同时解码的异步模式，系统不支持时自动退回同步模式
+        bool async_decode = false;
+        // 收到后排队超过这个时长的帧视为过期: 后面排着关键帧就直接跳过，否则只解码不显示.
+        // 最新的一帧总是会显示. 0表示不丢帧
+        uint32_t max_queue_age_ms = 100;
+        // true: 按采集节奏匀速显示，用自适应的缓冲吸收网络抖动; false: 总是显示最新的帧
+        bool smooth_playback = false;
+        // 非空时把收到的编码帧录制到这个文件，用StreamReplayer回放
+        std::string record_path;
     };
 
     enum class Action {
@@ -30,148 +30,183 @@
 
 #include "video_statistics.h"
 
+#include <algorithm>
+
 #include <ltlib/times.h>
 
 namespace lt {
 
-void VideoStatistics::addHistory(std::deque<int64_t>& history) {
-    int64_t now = ltlib::steady_now_us();
-    const int64_t kOneSecond = 1'000'000;
-    const int64_t kOneSecondBefore = now - kOneSecond;
-    history.push_back(now);
-    while (!history.empty()) {
-        if (history.front() < kOneSecondBefore) {
-            history.pop_front();
-        }
-        else {
-            break;
+void VideoStatistics::RateCounter::add(int64_t value, int64_t now_us) {
+    const int64_t id = now_us / kSlotUs;
+    Slot& slot = slots_[id % slots_.size()];
+    int64_t old_id = slot.id.load(std::memory_order_acquire);
+    if (old_id != id && slot.id.compare_exchange_strong(old_id, id, std::memory_order_acq_rel)) {
+        // 抢到了轮换权，丢掉上一轮的值
+        slot.value.exchange(value, std::memory_order_relaxed);
+        return;
+    }
+    slot.value.fetch_add(value, std::memory_order_relaxed);
+}
+
+int64_t VideoStatistics::RateCounter::sum(int64_t now_us) const {
+    const int64_t current = now_us / kSlotUs;
+    int64_t result = 0;
+    // 当前槽和之前的kWindowSlots - 1个槽全算
+    for (int64_t id = current - kWindowSlots + 1; id <= current; id++) {
+        const Slot& slot = slots_[id % slots_.size()];
+        if (slot.id.load(std::memory_order_acquire) == id) {
+            result += slot.value.load(std::memory_order_relaxed);
         }
     }
+    // 最老的槽只有一部分落在一秒内
+    const int64_t oldest = current - kWindowSlots;
+    const Slot& slot = slots_[oldest % slots_.size()];
+    if (slot.id.load(std::memory_order_acquire) == oldest) {
+        const int64_t elapsed = now_us - current * kSlotUs;
+        result += slot.value.load(std::memory_order_relaxed) * (kSlotUs - elapsed) / kSlotUs;
+    }
+    return result;
 }
 
-void VideoStatistics::updateHistory(History& time_entry, double value) {
-    constexpr size_t kMaxSize = 60;
+VideoStatistics::Window::Window(bool track_distribution) {
+    if (track_distribution) {
+        distribution_ = std::make_unique<ltlib::WindowedHistogram>();
+    }
+}
+
+void VideoStatistics::Window::update(double value, int64_t now_us) {
     constexpr int64_t kOneMinute = 60'000'000;
-    time_entry.history.push_back(value);
-    while (time_entry.history.size() > kMaxSize) {
-        time_entry.history.pop_front();
+    std::lock_guard lock{mutex_};
+    if (distribution_ != nullptr) {
+        distribution_->record(static_cast<int64_t>(value), now_us);
     }
-    double sum = 0;
-    for (auto val : time_entry.history) {
-        sum += val;
+    if (size_ == kMaxSize) {
+        sum_ -= values_[next_];
     }
-    time_entry.avg = sum / time_entry.history.size();
-    int64_t now = ltlib::steady_now_us();
-    if (time_entry.last_clear_time + kOneMinute < now) {
-        time_entry.last_clear_time = now;
-        time_entry.max = value;
-        time_entry.min = value;
+    else {
+        size_++;
+    }
+    values_[next_] = value;
+    sum_ += value;
+    next_ = (next_ + 1) % kMaxSize;
+    if (next_ == 0) {
+        // 每转一圈重新求和一次，消除浮点累加误差
+        sum_ = 0;
+        for (size_t i = 0; i < size_; i++) {
+            sum_ += values_[i];
+        }
+    }
+    if (last_clear_time_ + kOneMinute < now_us) {
+        last_clear_time_ = now_us;
+        max_ = value;
+        min_ = value;
     }
     else {
-        time_entry.max = std::max(time_entry.max, value);
-        time_entry.min = std::min(time_entry.min, value);
+        max_ = std::max(max_, value);
+        min_ = std::min(min_, value);
     }
 }
 
-VideoStatistics::Stat VideoStatistics::getStat() {
+VideoStatistics::History VideoStatistics::Window::snapshot() const {
+    History history;
     std::lock_guard lock{mutex_};
+    const size_t begin = size_ == kMaxSize ? next_ : 0;
+    for (size_t i = 0; i < size_; i++) {
+        history.history.push_back(values_[(begin + i) % kMaxSize]);
+    }
+    history.last_clear_time = last_clear_time_;
+    history.max = max_;
+    history.min = min_;
+    history.avg = size_ == 0 ? 0 : sum_ / size_;
+    if (distribution_ != nullptr) {
+        using Window = ltlib::WindowedHistogram::Window;
+        int64_t now = ltlib::steady_now_us();
+        history.last_1s = distribution_->summary(Window::OneSecond, now);
+        history.last_10s = distribution_->summary(Window::TenSeconds, now);
+        history.last_60s = distribution_->summary(Window::OneMinute, now);
+    }
+    return history;
+}
+
+VideoStatistics::Stat VideoStatistics::getStat() {
     Stat stat{};
-    stat.encode_time = encode_time_;
-    stat.render_video_time = render_video_time_;
-    stat.render_widgets_time = render_widgets_time_;
-    stat.present_time = present_time_;
-    stat.net_delay = net_delay_;
-    stat.decode_time = decode_time_;
-    stat.video_bw = video_bw_;
-    stat.loss_rate = loss_rate_;
-    stat.bwe = bwe_;
-
-    stat.render_video_fps = render_video_history_.size();
-    stat.present_fps = present_history_.size();
-    stat.encode_fps = encode_history_.size();
-    stat.capture_fps = capture_history_.size();
+    stat.encode_time = encode_time_.snapshot();
+    stat.render_video_time = render_video_time_.snapshot();
+    stat.render_widgets_time = render_widgets_time_.snapshot();
+    stat.present_time = present_time_.snapshot();
+    stat.net_delay = net_delay_.snapshot();
+    stat.decode_time = decode_time_.snapshot();
+    stat.video_bw = video_bw_.snapshot();
+    stat.loss_rate = loss_rate_.snapshot();
+    stat.bwe = bwe_.snapshot();
+
+    int64_t now = ltlib::steady_now_us();
+    stat.render_video_fps = render_video_counter_.sum(now);
+    stat.present_fps = present_counter_.sum(now);
+    stat.encode_fps = encode_counter_.sum(now);
+    stat.dropped_frames = dropped_frames_.load(std::memory_order_relaxed);
+    stat.missed_vsyncs = missed_vsyncs_.load(std::memory_order_relaxed);
 
     return stat;
 }
 
 void VideoStatistics::addRenderVideo() {
-    std::lock_guard lock{mutex_};
-    addHistory(render_video_history_);
+    render_video_counter_.add(1, ltlib::steady_now_us());
 }
 
 void VideoStatistics::addPresent() {
-    std::lock_guard lock{mutex_};
-    addHistory(present_history_);
+    present_counter_.add(1, ltlib::steady_now_us());
 }
 
 void VideoStatistics::addEncode() {
-    std::lock_guard lock{mutex_};
-    addHistory(encode_history_);
+    encode_counter_.add(1, ltlib::steady_now_us());
 }
 
 void VideoStatistics::updateEncodeTime(int64_t duration) {
-    std::lock_guard lock{mutex_};
-    updateHistory(encode_time_, static_cast<double>(duration));
+    encode_time_.update(static_cast<double>(duration), ltlib::steady_now_us());
 }
 
 void VideoStatistics::updateRenderVideoTime(int64_t duration) {
-    std::lock_guard lock{mutex_};
-    updateHistory(render_video_time_, static_cast<double>(duration));
+    render_video_time_.update(static_cast<double>(duration), ltlib::steady_now_us());
 }
 
 void VideoStatistics::updateRenderWidgetsTime(int64_t duration) {
-    std::lock_guard lock{mutex_};
-    updateHistory(render_widgets_time_, static_cast<double>(duration));
+    render_widgets_time_.update(static_cast<double>(duration), ltlib::steady_now_us());
 }
 
 void VideoStatistics::updatePresentTime(int64_t duration) {
-    std::lock_guard lock{mutex_};
-    updateHistory(present_time_, static_cast<double>(duration));
+    present_time_.update(static_cast<double>(duration), ltlib::steady_now_us());
 }
 
 void VideoStatistics::updateNetDelay(int64_t duration) {
-    std::lock_guard lock{mutex_};
-    updateHistory(net_delay_, static_cast<double>(duration));
+    net_delay_.update(static_cast<double>(duration), ltlib::steady_now_us());
 }
 
 void VideoStatistics::updateDecodeTime(int64_t duration) {
-    std::lock_guard lock{mutex_};
-    updateHistory(decode_time_, static_cast<double>(duration));
+    decode_time_.update(static_cast<double>(duration), ltlib::steady_now_us());
 }
 
 void VideoStatistics::updateVideoBW(int64_t bytes) {
-    const int64_t kOneSecond = 1'000'000;
     int64_t now = ltlib::steady_now_us();
-    int64_t sum = 0;
-    {
-        std::lock_guard lock{mutex_};
-        video_bw_history_.push_back({bytes, now});
-        while (!video_bw_history_.empty()) {
-            if (video_bw_history_.front().time + kOneSecond < now) {
-                video_bw_history_.pop_front();
-            }
-            else {
-                break;
-            }
-        }
-        for (auto& history : video_bw_history_) {
-            sum += history.bytes;
-        }
-    }
-    updateHistory(video_bw_, static_cast<double>(sum * 8 / 1024));
+    video_bytes_counter_.add(bytes, now);
+    int64_t sum = video_bytes_counter_.sum(now);
+    video_bw_.update(static_cast<double>(sum * 8 / 1024), now);
 }
 
-void VideoStatistics::updateLossRate(float rate) {
-    updateHistory(loss_rate_, rate * 100);
+void VideoStatistics::addDroppedFrames(uint32_t count) {
+    dropped_frames_.fetch_add(count, std::memory_order_relaxed);
 }
 
-void VideoStatistics::addCapture(const std::vector<uint32_t>&) {
-    std::lock_guard lock{mutex_};
-    addHistory(capture_history_);
+void VideoStatistics::addMissedVsyncs(uint32_t count) {
+    missed_vsyncs_.fetch_add(count, std::memory_order_relaxed);
+}
+
+void VideoStatistics::updateLossRate(float rate) {
+    loss_rate_.update(rate * 100, ltlib::steady_now_us());
 }
 
 void VideoStatistics::updateBWE(uint32_t bps) {
-    updateHistory(bwe_, static_cast<double>(bps / 1024));
+    bwe_.update(static_cast<double>(bps / 1024), ltlib::steady_now_us());
 }
 
-} // namespace lt
\ No newline at end of file
+} // namespace lt
@@ -29,14 +29,20 @@
  */
 
 #pragma once
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <deque>
 #include <memory>
 #include <mutex>
 #include <vector>
 
+#include <ltlib/histogram.h>
+
 namespace lt {
 
+// 各个指标互相独立，分别由transport、解码、渲染线程更新，互不争用.
+// 计数类指标是无锁的，耗时类指标每个指标一把锁，只和1秒一次的getStat()竞争.
 class VideoStatistics {
 public:
     struct History {
@@ -45,6 +51,10 @@ public:
         double max = 0;
         double min = 0;
         double avg = 0;
+        // 分布，单位同上. 只有解码、渲染、上屏耗时和网络延迟有
+        ltlib::WindowedHistogram::Summary last_1s;
+        ltlib::WindowedHistogram::Summary last_10s;
+        ltlib::WindowedHistogram::Summary last_60s;
     };
     struct Stat {
         History encode_time;
@@ -59,7 +69,8 @@ public:
         int64_t render_video_fps;
         int64_t present_fps;
         int64_t encode_fps;
-        int64_t capture_fps;
+        int64_t dropped_frames; // 累计值
+        int64_t missed_vsyncs;  // 累计值
     };
 
 public:
@@ -75,36 +86,69 @@ public:
     void updateNetDelay(int64_t duration);
     void updateDecodeTime(int64_t duration);
     void updateVideoBW(int64_t bytes); // 特殊处理
+    void addDroppedFrames(uint32_t count);
+    void addMissedVsyncs(uint32_t count);
 
     // 独立消息
     void updateLossRate(float loss);
-    void addCapture(const std::vector<uint32_t>& fps);
     void updateBWE(uint32_t bps);
 
 private:
-    static void addHistory(std::deque<int64_t>& history);
-    static void updateHistory(History& time_entry, double value);
+    // 最近一秒内的累加值. 时间按100ms分槽，每个槽一个原子计数，最老的槽按剩余比例折算.
+    // 多个线程可以同时add，槽位轮换的瞬间并发的add可能被丢掉，对统计来说可以接受
+    class RateCounter {
+    public:
+        void add(int64_t value, int64_t now_us);
+        int64_t sum(int64_t now_us) const;
 
-private:
-    std::mutex mutex_;
-    std::deque<int64_t> render_video_history_;
-    std::deque<int64_t> present_history_;
-    std::deque<int64_t> encode_history_;
-    std::deque<int64_t> capture_history_;
-    History encode_time_;
-    History render_video_time_;
-    History render_widgets_time_;
-    History present_time_;
-    History net_delay_;
-    History decode_time_;
-    History bwe_;
-    History loss_rate_;
-    History video_bw_;
-    struct VideoBW {
-        int64_t bytes;
-        int64_t time;
+    private:
+        static constexpr int64_t kSlotUs = 100'000;
+        static constexpr int64_t kWindowSlots = 10;
+        struct Slot {
+            std::atomic<int64_t> id{-1};
+            std::atomic<int64_t> value{0};
+        };
+        // 多留一个槽，正在写的槽不会覆盖还要读的最老的槽
+        std::array<Slot, kWindowSlots + 2> slots_;
     };
-    std::deque<VideoBW> video_bw_history_;
+
+    // 最近kMaxSize个值的滑动窗口，维护累加和，更新是O(1)的. min/max每分钟重置一次.
+    // track_distribution为true时同时记录1秒/10秒/60秒的分布
+    class Window {
+    public:
+        explicit Window(bool track_distribution = false);
+        void update(double value, int64_t now_us);
+        History snapshot() const;
+
+    private:
+        static constexpr size_t kMaxSize = 60;
+        mutable std::mutex mutex_;
+        std::array<double, kMaxSize> values_{};
+        size_t next_ = 0;
+        size_t size_ = 0;
+        double sum_ = 0;
+        double max_ = 0;
+        double min_ = 0;
+        int64_t last_clear_time_ = 0;
+        std::unique_ptr<ltlib::WindowedHistogram> distribution_;
+    };
+
+private:
+    RateCounter render_video_counter_;
+    RateCounter present_counter_;
+    RateCounter encode_counter_;
+    RateCounter video_bytes_counter_;
+    Window encode_time_;
+    Window render_video_time_{true};
+    Window render_widgets_time_;
+    Window present_time_{true};
+    Window net_delay_{true};
+    Window decode_time_{true};
+    Window bwe_;
+    Window loss_rate_;
+    Window video_bw_;
+    std::atomic<int64_t> dropped_frames_{0};
+    std::atomic<int64_t> missed_vsyncs_{0};
 };
 
-} // namespace lt
\ No newline at end of file
+} // namespace lt
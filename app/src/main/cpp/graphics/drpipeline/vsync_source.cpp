@@ -0,0 +1,89 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vsync_source.h"
+
+#include <thread>
+
+#include <ltlib/logging.h>
+#include <ltlib/times.h>
+
+#if defined(LT_ANDROID)
+#include "choreographer_vsync_source.h"
+#endif // LT_ANDROID
+
+namespace {
+
+constexpr uint32_t kDefaultRefreshRate = 60;
+
+} // namespace
+
+namespace lt {
+
+std::unique_ptr<VsyncSource> VsyncSource::create(uint32_t refresh_rate) {
+    if (refresh_rate == 0) {
+        LOG(WARNING) << "Unknown screen refresh rate, assume " << kDefaultRefreshRate << "Hz";
+        refresh_rate = kDefaultRefreshRate;
+    }
+#if defined(LT_ANDROID)
+    auto choreographer = ChoreographerVsyncSource::create(refresh_rate);
+    if (choreographer != nullptr) {
+        return choreographer;
+    }
+#endif // LT_ANDROID
+    LOG(INFO) << "Using simulated vsync at " << refresh_rate << "Hz";
+    return std::make_unique<SimulatedVsyncSource>(refresh_rate);
+}
+
+SimulatedVsyncSource::SimulatedVsyncSource(uint32_t refresh_rate)
+    : period_us_{1'000'000 / static_cast<int64_t>(refresh_rate)}
+    , start_us_{ltlib::steady_now_us()} {}
+
+std::optional<int64_t> SimulatedVsyncSource::waitForVsync(std::chrono::microseconds max_wait) {
+    int64_t now = ltlib::steady_now_us();
+    // 下一个还没返回过的vsync
+    int64_t next = start_us_ + ((now - start_us_) / period_us_ + 1) * period_us_;
+    if (next <= last_vsync_us_) {
+        next = last_vsync_us_ + period_us_;
+    }
+    if (next - now > max_wait.count()) {
+        std::this_thread::sleep_for(max_wait);
+        return {};
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds{next - now});
+    last_vsync_us_ = next;
+    return next;
+}
+
+int64_t SimulatedVsyncSource::periodUs() const {
+    return period_us_;
+}
+
+} // namespace lt
@@ -0,0 +1,66 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace lt {
+
+// 显示器的垂直同步信号. 时间戳和ltlib::steady_now_us()同一时基
+class VsyncSource {
+public:
+    // 设备上优先用Choreographer，不可用时(API 24以下、host)退回按刷新率计时的模拟信号
+    static std::unique_ptr<VsyncSource> create(uint32_t refresh_rate);
+    virtual ~VsyncSource() = default;
+
+    // 等待下一个vsync，返回它的时间戳，超时返回空
+    virtual std::optional<int64_t> waitForVsync(std::chrono::microseconds max_wait) = 0;
+
+    virtual int64_t periodUs() const = 0;
+};
+
+// 按刷新率计时产生vsync，相位固定，不随调用时间漂移
+class SimulatedVsyncSource : public VsyncSource {
+public:
+    explicit SimulatedVsyncSource(uint32_t refresh_rate);
+    std::optional<int64_t> waitForVsync(std::chrono::microseconds max_wait) override;
+    int64_t periodUs() const override;
+
+private:
+    const int64_t period_us_;
+    const int64_t start_us_;
+    int64_t last_vsync_us_ = 0;
+};
+
+} // namespace lt
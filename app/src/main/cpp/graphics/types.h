@@ -65,6 +65,8 @@ enum class VaType {
     VAAPI,
     AndroidGL,
     AndroidDummy,
+    // FakeVideoDecoder，只在host上注册
+    Fake,
 };
 
 } // namespace lt
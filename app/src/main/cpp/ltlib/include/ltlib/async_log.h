@@ -0,0 +1,153 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <ltlib/ltlib.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace ltlib
+{
+
+// 异步日志. 启动后LOG/LOGF在调用线程只把格式串指针和原始参数拷进本线程的环形缓冲区,
+// 格式化和输出(logcat/stderr/文件)都在后台线程. 没有启动或者已经停止时同步输出.
+// 缓冲区写满时丢弃新日志并计数，不会阻塞调用线程. FATAL级别总是先flush再同步输出.
+struct AsyncLogOptions
+{
+    // 安卓输出到logcat，host输出到stderr，不和benchmark写到stdout的结果混在一起
+    bool console = true;
+    // 非空时同时追加写到这个文件
+    std::string file_path;
+    // 每个线程的缓冲区字节数
+    size_t buffer_size = 64 * 1024;
+    // 后台线程没有被唤醒时多久检查一次缓冲区
+    uint32_t flush_interval_ms = 20;
+};
+
+LT_API bool start_async_logging(const AsyncLogOptions& options);
+// 输出剩下的日志后停止后台线程
+LT_API void stop_async_logging();
+// 阻塞到调用之前提交的日志都已输出
+LT_API void flush_logs();
+
+namespace log_detail
+{
+
+enum class ArgType : uint8_t
+{
+    None,
+    Int,
+    UInt,
+    Double,
+    String,
+    Pointer,
+};
+
+struct Arg
+{
+    ArgType type = ArgType::None;
+    union
+    {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const void* p;
+        const char* s;
+    };
+    Arg()
+        : i { 0 }
+    {
+    }
+};
+
+inline const char* null_to_text(const char* str)
+{
+    return str == nullptr ? "(null)" : str;
+}
+
+template <typename T> inline Arg make_arg(const T& value)
+{
+    Arg arg;
+    using U = std::decay_t<T>;
+    // 只有char*当作字符串. uint8_t*之类一般是二进制数据，按%s拷贝会越界读到第一个0为止
+    if constexpr (std::is_same_v<U, char*> || std::is_same_v<U, const char*>) {
+        arg.type = ArgType::String;
+        arg.s = null_to_text(reinterpret_cast<const char*>(value));
+    }
+    else if constexpr (std::is_pointer_v<U> || std::is_null_pointer_v<U>) {
+        arg.type = ArgType::Pointer;
+        arg.p = reinterpret_cast<const void*>(value);
+    }
+    else if constexpr (std::is_floating_point_v<U>) {
+        arg.type = ArgType::Double;
+        arg.d = static_cast<double>(value);
+    }
+    else if constexpr (std::is_enum_v<U>) {
+        return make_arg(static_cast<std::underlying_type_t<U>>(value));
+    }
+    else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+        arg.type = ArgType::Int;
+        arg.i = static_cast<int64_t>(value);
+    }
+    else {
+        static_assert(std::is_integral_v<U>, "unsupported LOGF argument type");
+        arg.type = ArgType::UInt;
+        arg.u = static_cast<uint64_t>(value);
+    }
+    return arg;
+}
+
+// fmt必须是字符串字面量，异步模式下只保存指针
+LT_API void log_printf(int level, const char* fmt, const Arg* args, size_t count);
+LT_API void log_text(int level, const char* text, size_t size);
+// 按printf规则格式化，参数类型和转换符不一致时按转换符转换
+LT_API std::string format(const char* fmt, const Arg* args, size_t count);
+
+// 只用来让编译器按printf检查LOGF的格式串和参数，不会被调用
+#if defined(__GNUC__)
+__attribute__((format(printf, 1, 2)))
+#endif
+inline void check_format(const char*, ...)
+{
+}
+
+} // namespace log_detail
+
+template <typename... Args>
+inline void log_printf(int level, const char* fmt, const Args&... args)
+{
+    const log_detail::Arg packed[] = { log_detail::make_arg(args)..., log_detail::Arg {} };
+    log_detail::log_printf(level, fmt, packed, sizeof...(Args));
+}
+
+} // namespace ltlib
@@ -0,0 +1,75 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <ltlib/ltlib.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace ltlib
+{
+
+// 给无锁队列用的等待/唤醒原语. Linux/Android下基于futex，没有等待者时notify()只有一次原子读.
+// 消费者的用法:
+//     auto key = ec.prepare_wait();
+//     if (队列非空) { ec.cancel_wait(); } else { ec.wait_for(key, timeout); }
+// 生产者入队后调用notify().
+class LT_API EventCount
+{
+public:
+    using Key = uint32_t;
+
+public:
+    EventCount() = default;
+    Key prepare_wait();
+    void cancel_wait();
+    // 返回false表示超时
+    bool wait_for(Key key, std::chrono::microseconds timeout);
+    void notify();
+    // 只唤醒一个已经睡下的等待者，多个线程等同一个队列时用它避免惊群
+    void notify_one();
+
+private:
+    EventCount(const EventCount&) = delete;
+    EventCount& operator=(const EventCount&) = delete;
+
+private:
+    std::atomic<uint32_t> seq_ { 0 };
+    std::atomic<uint32_t> waiters_ { 0 };
+#if !defined(LT_LINUX) && !defined(LT_ANDROID)
+    std::mutex mutex_;
+    std::condition_variable cv_;
+#endif
+};
+
+} // namespace ltlib
@@ -0,0 +1,129 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <ltlib/ltlib.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ltlib
+{
+
+// 对数-线性分桶的直方图(HDR histogram的简化版)，用来统计耗时分布.
+// 小于16的值每个值一个桶，之后每个2的幂区间分成8个桶，相对误差不超过12.5%，上限约134秒.
+// 所有操作都是relaxed原子操作，多个线程可以同时record，读到的是近似的快照.
+class LT_API Histogram
+{
+public:
+    static constexpr size_t kSubBucketBits = 3;
+    static constexpr size_t kLinearBuckets = 16;
+    static constexpr size_t kMaxExponent = 27;
+    static constexpr size_t kBucketCount =
+        kLinearBuckets + (kMaxExponent - 4) * (size_t { 1 } << kSubBucketBits);
+
+public:
+    Histogram() = default;
+    // 负数按0算，超过上限的值算进最后一个桶
+    void record(int64_t value);
+    void merge(const Histogram& other);
+    void reset();
+    uint64_t count() const;
+    int64_t max() const;
+    // p取值[0, 100]，返回该分位所在桶的上界. 没有数据时返回0
+    int64_t percentile(double p) const;
+
+    static size_t bucket_index(int64_t value);
+    static int64_t bucket_upper_bound(size_t index);
+
+private:
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+private:
+    std::array<std::atomic<uint32_t>, kBucketCount> buckets_ {};
+    std::atomic<uint64_t> count_ { 0 };
+    std::atomic<int64_t> max_ { 0 };
+};
+
+// 按1秒、10秒、60秒三档时间窗口统计分布，查询的是最近一个完整窗口，还没有完整窗口时用当前窗口.
+// 每档两个Histogram轮换，小窗口结束时合并进大一档的窗口，内存固定在6个Histogram(约5KB).
+// 不是线程安全的，需要调用者加锁.
+class LT_API WindowedHistogram
+{
+public:
+    enum class Window : uint8_t
+    {
+        OneSecond,
+        TenSeconds,
+        OneMinute,
+    };
+    static constexpr size_t kWindowCount = 3;
+
+    struct Summary
+    {
+        uint64_t count = 0;
+        int64_t p50 = 0;
+        int64_t p90 = 0;
+        int64_t p99 = 0;
+        int64_t p999 = 0;
+        int64_t max = 0;
+    };
+
+public:
+    WindowedHistogram() = default;
+    void record(int64_t value, int64_t now_us);
+    Summary summary(Window window, int64_t now_us);
+    // 把某个窗口的分布合并进out，用于汇总多个来源
+    void merge_into(Window window, int64_t now_us, Histogram& out);
+
+private:
+    WindowedHistogram(const WindowedHistogram&) = delete;
+    WindowedHistogram& operator=(const WindowedHistogram&) = delete;
+    void rotate(int64_t now_us);
+    const Histogram& select(Window window, int64_t now_us);
+
+private:
+    struct Tier
+    {
+        explicit Tier(int64_t period)
+            : period_us { period }
+        {
+        }
+        const int64_t period_us;
+        int64_t id = -1;
+        size_t current = 0;
+        Histogram histograms[2];
+    };
+    Tier tiers_[kWindowCount] { Tier { 1'000'000 }, Tier { 10'000'000 }, Tier { 60'000'000 } };
+};
+
+} // namespace ltlib
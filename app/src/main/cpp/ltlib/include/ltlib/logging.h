@@ -30,10 +30,28 @@
 
 #pragma once
 
+#include <atomic>
 #include <cinttypes>
 #include <sstream>
 
+#if defined(LT_ANDROID)
 #include <android/log.h>
+#else
+// 在host上编译(比如benchmark)时没有android/log.h，沿用同样的优先级定义，日志写到stderr
+typedef enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT,
+} android_LogPriority;
+#endif
+
+#include <ltlib/async_log.h>
 
 #define DEBUG ANDROID_LOG_DEBUG
 #define INFO ANDROID_LOG_INFO
@@ -41,6 +59,16 @@
 #define ERR ANDROID_LOG_ERROR
 #define FATAL ANDROID_LOG_FATAL
 
+// 编译期的最低日志级别，低于它的LOG/LOGF连同参数的求值一起被编译器去掉.
+// release默认去掉DEBUG，可以在编译选项里覆盖，比如-DLT_MIN_LOG_LEVEL=ANDROID_LOG_WARN
+#if !defined(LT_MIN_LOG_LEVEL)
+#if defined(NDEBUG)
+#define LT_MIN_LOG_LEVEL ANDROID_LOG_INFO
+#else
+#define LT_MIN_LOG_LEVEL ANDROID_LOG_DEBUG
+#endif
+#endif
+
 namespace ltlib {
 
 bool logLevel(const android_LogPriority& level);
@@ -62,9 +90,46 @@ private:
     const android_LogPriority _level;
 };
 
+// LOG_EVERY_N/LOG_FIRST_N/LOG_EVERY_T每个调用点一个计数器
+class LogOccurrences {
+public:
+    // n为0或1时每次都打印
+    bool every_n(uint64_t n) {
+        return n <= 1 || count_.fetch_add(1, std::memory_order_relaxed) % n == 0;
+    }
+    bool first_n(uint64_t n) {
+        return count_.load(std::memory_order_relaxed) < n &&
+               count_.fetch_add(1, std::memory_order_relaxed) < n;
+    }
+
+private:
+    std::atomic<uint64_t> count_{0};
+};
+
+class LogEveryT {
+public:
+    // 距离上次返回true超过seconds秒才返回true，第一次总是true
+    bool check(double seconds);
+
+private:
+    std::atomic<int64_t> last_ms_{-1};
+};
+
 } // namespace ltlib
 
-#define LOGF(level, ...) __android_log_print(level, "ltmsdk", __VA_ARGS__)
+#define LT_LOG_ENABLED(level) ((level) >= LT_MIN_LOG_LEVEL && ltlib::logLevel(level))
+
+// 第一个参数必须是字符串字面量，启用异步日志后在后台线程格式化.
+// 永远不会执行的check_format()让-Wformat照样检查格式串和参数
+#define LOGF(level, ...)                                                                           \
+    do {                                                                                           \
+        if (LT_LOG_ENABLED(level)) {                                                               \
+            ltlib::log_printf(level, __VA_ARGS__);                                                 \
+        }                                                                                          \
+        if (false) {                                                                               \
+            ltlib::log_detail::check_format(__VA_ARGS__);                                          \
+        }                                                                                          \
+    } while (false)
 
 #if defined(_MSC_VER) && (defined(WINDOWS_FUNCSIG)) // Microsoft
 #define G3LOG_PRETTY_FUNCTION __FUNCSIG__
@@ -78,7 +143,29 @@ private:
     ltlib::LogCapture(__FILE__, __LINE__, static_cast<const char*>(G3LOG_PRETTY_FUNCTION), level)
 
 #define LOG(level)                                                                                 \
-    if (!ltlib::logLevel(level)) {                                                                        \
+    if (!LT_LOG_ENABLED(level)) {                                                                  \
     }                                                                                              \
     else                                                                                           \
-        INTERNAL_LOG_MESSAGE(level).stream()
\ No newline at end of file
+        INTERNAL_LOG_MESSAGE(level).stream()
+
+// 条件为true时才打印. 级别没有打开时不会对条件求值
+#define LOG_IF(level, condition)                                                                   \
+    if (!(LT_LOG_ENABLED(level) && (condition))) {                                                 \
+    }                                                                                              \
+    else                                                                                           \
+        INTERNAL_LOG_MESSAGE(level).stream()
+
+// 每个调用点自己的静态状态，可以像LOG一样用在表达式里
+#define LT_LOG_SITE_STATE(type)                                                                    \
+    ([]() -> type& {                                                                               \
+        static type state;                                                                         \
+        return state;                                                                              \
+    }())
+
+// 第1、n+1、2n+1...次打印
+#define LOG_EVERY_N(level, n) LOG_IF(level, LT_LOG_SITE_STATE(ltlib::LogOccurrences).every_n(n))
+// 只打印前n次
+#define LOG_FIRST_N(level, n) LOG_IF(level, LT_LOG_SITE_STATE(ltlib::LogOccurrences).first_n(n))
+// 最多每seconds秒打印一次
+#define LOG_EVERY_T(level, seconds)                                                                \
+    LOG_IF(level, LT_LOG_SITE_STATE(ltlib::LogEveryT).check(seconds))
@@ -0,0 +1,170 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ltlib
+{
+
+// 任务是从哪里投递的. 作为默认参数Location::current()时，__builtin_FILE()等在调用处求值，
+// 效果和C++20的std::source_location一样，调用者不用写宏.
+// 不记函数名: 大部分任务是在lambda里投递的，__builtin_FUNCTION()只会得到"operator()"
+struct Location
+{
+    const char* file = nullptr;
+    int line = 0;
+
+    static constexpr Location current(const char* file = __builtin_FILE(),
+                                      int line = __builtin_LINE())
+    {
+        return Location { file, line };
+    }
+};
+
+// 只能移动的void()可调用对象，代替std::function<void()>投递任务.
+// 不超过kInlineSize字节的可调用对象直接放在内部缓冲里，不分配内存；更大的才放到堆上.
+// 捕获几个指针、一个shared_ptr或者一个std::function的lambda都能放下.
+class Task
+{
+public:
+    static constexpr size_t kInlineSize = 48;
+
+public:
+    Task() noexcept = default;
+    Task(std::nullptr_t) noexcept {}
+
+    template <typename F,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task> &&
+                                          std::is_invocable_r_v<void, std::decay_t<F>&>>>
+    Task(F&& func)
+    {
+        using Func = std::decay_t<F>;
+        if constexpr (kFitsInline<Func>) {
+            new (storage_) Func(std::forward<F>(func));
+            ops_ = &InlineOps<Func>::kOps;
+        }
+        else {
+            *reinterpret_cast<Func**>(storage_) = new Func(std::forward<F>(func));
+            ops_ = &HeapOps<Func>::kOps;
+        }
+    }
+
+    Task(Task&& other) noexcept { move_from(other); }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    Task& operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    ~Task() { reset(); }
+
+    void operator()() { ops_->invoke(storage_); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+private:
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    struct Ops
+    {
+        void (*invoke)(void* storage);
+        // 把src的对象移动到dst，并析构src
+        void (*relocate)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <typename Func>
+    static constexpr bool kFitsInline = sizeof(Func) <= kInlineSize &&
+                                        alignof(Func) <= alignof(std::max_align_t) &&
+                                        std::is_nothrow_move_constructible_v<Func>;
+
+    template <typename Func>
+    struct InlineOps
+    {
+        static void invoke(void* storage) { (*static_cast<Func*>(storage))(); }
+        static void relocate(void* dst, void* src) noexcept
+        {
+            new (dst) Func(std::move(*static_cast<Func*>(src)));
+            static_cast<Func*>(src)->~Func();
+        }
+        static void destroy(void* storage) noexcept { static_cast<Func*>(storage)->~Func(); }
+        static constexpr Ops kOps { &invoke, &relocate, &destroy };
+    };
+
+    template <typename Func>
+    struct HeapOps
+    {
+        static void invoke(void* storage) { (**static_cast<Func**>(storage))(); }
+        static void relocate(void* dst, void* src) noexcept
+        {
+            *static_cast<Func**>(dst) = *static_cast<Func**>(src);
+        }
+        static void destroy(void* storage) noexcept { delete *static_cast<Func**>(storage); }
+        static constexpr Ops kOps { &invoke, &relocate, &destroy };
+    };
+
+    void move_from(Task& other) noexcept
+    {
+        if (other.ops_ != nullptr) {
+            other.ops_->relocate(storage_, other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    void reset() noexcept
+    {
+        if (ops_ != nullptr) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const Ops* ops_ = nullptr;
+};
+
+} // namespace ltlib
@@ -0,0 +1,108 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <ltlib/ltlib.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <ltlib/histogram.h>
+#include <ltlib/task.h>
+
+namespace ltlib
+{
+
+// TaskThread和Strand的任务耗时统计: 排队时间、执行时间、定时任务晚了多久，以及最近的慢任务.
+// 执行任务的线程记录，任意线程都可以读. 记录只是几次relaxed原子操作，慢任务才加锁.
+class LT_API TaskMetrics
+{
+public:
+    static constexpr int64_t kDefaultSlowTaskUs = 20'000;
+    static constexpr size_t kMaxSlowTasks = 16;
+
+    // 单位微秒
+    struct Distribution
+    {
+        uint64_t count = 0;
+        int64_t p50 = 0;
+        int64_t p99 = 0;
+        int64_t max = 0;
+    };
+
+    struct SlowTask
+    {
+        Location from;
+        bool delayed = false;
+        // 普通任务是排队时间，定时任务是比预定时间晚了多久
+        int64_t wait_us = 0;
+        int64_t run_us = 0;
+    };
+
+    struct Snapshot
+    {
+        Distribution queue_wait_us;
+        Distribution run_us;
+        Distribution delay_late_us;
+        uint64_t slow_task_count = 0;
+        // 最近的kMaxSlowTasks个，按时间先后
+        std::vector<SlowTask> slow_tasks;
+
+        std::string toString() const;
+    };
+
+public:
+    TaskMetrics() = default;
+    // 排队(或迟到)时间、执行时间任一超过阈值就算慢任务
+    void set_slow_task_threshold(int64_t us);
+    void record(const Location& from, int64_t queue_wait_us, int64_t run_us);
+    void record_delayed(const Location& from, int64_t late_us, int64_t run_us);
+    // 取出上次调用以来的统计并清零. 和record()并发时个别样本可能算到下一次
+    Snapshot collect();
+
+private:
+    TaskMetrics(const TaskMetrics&) = delete;
+    TaskMetrics& operator=(const TaskMetrics&) = delete;
+    void record_slow(const SlowTask& task);
+
+private:
+    Histogram queue_wait_us_;
+    Histogram run_us_;
+    Histogram delay_late_us_;
+    std::atomic<int64_t> slow_task_us_ { kDefaultSlowTaskUs };
+    std::mutex mutex_;
+    std::array<SlowTask, kMaxSlowTasks> slow_tasks_ {};
+    uint64_t slow_task_count_ = 0;
+};
+
+} // namespace ltlib
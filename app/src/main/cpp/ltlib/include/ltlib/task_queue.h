@@ -0,0 +1,103 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <ltlib/ltlib.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include <ltlib/mpsc_queue.h>
+#include <ltlib/task.h>
+
+namespace ltlib
+{
+
+// TaskThread的任务队列: IntrusiveMpscQueue加上一个节点池.
+// 节点按块分配、只增不减，空闲节点串在带版本号的无锁栈上. 稳态下push()既不加锁也不分配内存，
+// 只有节点池耗尽、需要再分配一块时才加锁. 节点池满了之后退化成每个任务new一个节点.
+class LT_API TaskQueue
+{
+public:
+    // 跟任务一起排队的附加信息，给TaskMetrics用
+    struct Meta
+    {
+        // 普通任务是入队时间；定时任务转投过来时是预定的执行时间
+        int64_t enqueue_us = 0;
+        Location from;
+        bool delayed = false;
+    };
+
+public:
+    TaskQueue() = default;
+    ~TaskQueue();
+    // 任意线程
+    void push(Task task) { push(std::move(task), Meta{}); }
+    void push(Task task, const Meta& meta);
+    // 以下只能在消费者线程调用. 取不到返回false，此时empty()为false说明有生产者正在push()，稍后重试
+    bool pop(Task& task);
+    bool pop(Task& task, Meta& meta);
+    bool empty() const;
+
+private:
+    TaskQueue(const TaskQueue&) = delete;
+    TaskQueue& operator=(const TaskQueue&) = delete;
+
+    static constexpr uint32_t kChunkBits = 6;
+    static constexpr uint32_t kChunkSize = 1u << kChunkBits;
+    static constexpr uint32_t kMaxChunks = 1024;
+    static constexpr uint32_t kNil = UINT32_MAX;
+    static constexpr uint32_t kHeapNode = UINT32_MAX - 1;
+
+    struct Node
+    {
+        std::atomic<Node*> next { nullptr };
+        std::atomic<uint32_t> next_free { kNil };
+        uint32_t index = kNil;
+        Task task;
+        Meta meta;
+    };
+
+    Node* acquire();
+    Node* grow();
+    void release(Node* node);
+    Node* node_at(uint32_t index) const;
+
+private:
+    IntrusiveMpscQueue<Node> queue_;
+    // 高32位是版本号，防止ABA；低32位是栈顶节点的下标
+    std::atomic<uint64_t> free_top_ { kNil };
+    std::array<std::atomic<Node*>, kMaxChunks> chunks_ {};
+    uint32_t chunk_count_ = 0;
+    std::mutex grow_mutex_;
+};
+
+} // namespace ltlib
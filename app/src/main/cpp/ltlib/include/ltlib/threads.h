@@ -30,6 +30,7 @@
 
 #pragma once
 #include <ltlib/ltlib.h>
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -40,24 +41,87 @@
 #include <atomic>
 #include <condition_variable>
 #include <map>
+#include <optional>
 #include <queue>
+#include <vector>
 
+#include <ltlib/event_count.h>
+#include <ltlib/histogram.h>
+#include <ltlib/task.h>
+#include <ltlib/task_metrics.h>
+#include <ltlib/task_queue.h>
 #include <ltlib/times.h>
+#include <ltlib/timing_wheel.h>
 
 namespace ltlib
 {
 
+// 线程的调度参数，创建线程时传入，在线程刚启动时设置. 都是尽力而为，没有权限或者平台不支持时
+// 只打日志，不影响线程创建.
+struct LT_API ThreadOptions
+{
+    enum class Policy
+    {
+        // 不改调度策略. 像音频回调这种系统给的线程可能已经是实时策略，不要把它降回普通
+        Keep,
+        Normal,
+        Fifo,
+        RoundRobin,
+    };
+    enum class Cores
+    {
+        Any,
+        // 按cpu_capacity区分. 三丛集的SoC上，除了容量最小的那一簇都算大核
+        Big,
+        Little,
+    };
+    Policy policy = Policy::Keep;
+    // Keep/Normal时是nice值(-20~19，越小越优先)，Fifo/RoundRobin时是实时优先级(1~99). 空表示不改
+    std::optional<int> priority;
+    // 第i位为1表示允许跑在CPU i上，0表示不限制. 和cores同时指定时取交集，交集为空就只用affinity_mask
+    uint64_t affinity_mask = 0;
+    Cores cores = Cores::Any;
+};
+
+// 把options应用到当前线程，全部成功返回true
+LT_API bool apply_thread_options(const ThreadOptions& options);
+// 从/sys/devices/system/cpu/cpu*/cpu_capacity(没有的话用cpufreq/cpuinfo_max_freq)推出的大小核掩码，
+// 只算一次. 所有核一样时两个掩码都包含全部核，读不到时返回0
+LT_API uint64_t big_cores_mask();
+LT_API uint64_t little_cores_mask();
+
+// 每个注册的线程占一个独立缓存行的心跳槽，上报心跳只写自己的槽，检测线程不加锁扫描所有槽.
+// 只有注册、注销和发现超时的时候才加锁.
 class LT_API ThreadWatcher
 {
 public:
     static constexpr int64_t kMaxBlockTimeMS = 5'000;
+    // 线程按这个间隔上报心跳，心跳间隔分布里超出它的部分就是线程卡住(或者睡眠)的时间
+    static constexpr int64_t kReportIntervalMS = 100;
+    static constexpr size_t kMaxThreads = 64;
+    using SlotID = int32_t;
+    static constexpr SlotID kInvalidSlot = -1;
+
+    // 心跳间隔分布，单位毫秒
+    struct StallStat
+    {
+        std::string name;
+        uint64_t count = 0;
+        int64_t p50 = 0;
+        int64_t p99 = 0;
+        int64_t max = 0;
+    };
 
 public:
     static ThreadWatcher* instance();
     ~ThreadWatcher();
-    void add(const std::string& name, std::thread::id thread_id);
-    void remove(const std::string& name);
-    void reportAlive(const std::string& name);
+    // 槽用完时返回kInvalidSlot，这个线程就不受监控
+    SlotID add(const std::string& name, std::thread::id thread_id);
+    void remove(SlotID slot);
+    // 只能由注册这个槽的线程调用. 不加锁，now_ms取自steady_now_ms()
+    void reportAlive(SlotID slot, int64_t now_ms);
+    // 所有已注册线程的心跳间隔分布，给统计界面用
+    std::vector<StallStat> stallStats();
     void registerTerminateCallback(const std::function<void(const std::string&)>& callback);
     void enableCrashOnTimeout();
     void disableCrashOnTimeout();
@@ -70,20 +134,31 @@ private:
     ThreadWatcher& operator=(const ThreadWatcher&&) = delete;
     void checkLoop();
 
+    StallStat stallStat(SlotID slot);
+
 private:
+    // 热数据，每个槽独占一个缓存行，不同线程上报心跳互不干扰
+    struct alignas(64) Heartbeat
+    {
+        std::atomic<int64_t> last_active_ms { 0 };
+        std::atomic<bool> in_use { false };
+    };
+    // 冷数据. name和thread_id只在持有mutex_时读写
     struct ThreadInfo
     {
         std::string name;
         std::thread::id thread_id;
-        int64_t last_active_time;
+        Histogram stall_ms;
     };
-    std::thread thread_;
+    std::array<Heartbeat, kMaxThreads> heartbeats_;
+    std::array<ThreadInfo, kMaxThreads> infos_;
     std::mutex mutex_;
     std::condition_variable cv_;
     bool stoped_ = false;
-    std::map<std::string, ThreadInfo> threads_;
     std::function<void(const std::string&)> terminate_callback_;
     std::atomic<bool> enable_crash_ { true };
+    // 放在最后，保证线程启动时其它成员都已经构造好
+    std::thread thread_;
 };
 
 class LT_API BlockingThread
@@ -92,12 +167,15 @@ public:
     using EntryFunction = std::function<void(std::function<void()> /*i_am_alive*/)>;
 
 public:
-    static std::unique_ptr<BlockingThread> create(const std::string& prefix, const EntryFunction& user_func);
+    static std::unique_ptr<BlockingThread> create(const std::string& prefix,
+                                                  const EntryFunction& user_func,
+                                                  const ThreadOptions& options = {});
     bool is_current_thread() const;
     ~BlockingThread();
 
 private:
-    BlockingThread(const std::string& prefix, const EntryFunction& func);
+    BlockingThread(const std::string& prefix, const EntryFunction& func,
+                   const ThreadOptions& options);
     BlockingThread(const BlockingThread&) = delete;
     BlockingThread& operator=(const BlockingThread&) = delete;
     BlockingThread(BlockingThread&&) = delete;
@@ -113,6 +191,8 @@ private:
     std::thread thread_;
     std::string name_;
     const EntryFunction user_func_;
+    const ThreadOptions options_;
+    ThreadWatcher::SlotID watch_slot_ = ThreadWatcher::kInvalidSlot;
     int64_t last_report_time_;
 };
 
@@ -130,18 +210,23 @@ inline bool operator<(const Priority& left, const Priority& right)
 class LT_API TaskThread
 {
 public:
-    using Task = std::function<void()>;
-    using TimerID = int64_t;
+    using Task = ::ltlib::Task;
+    using TimerID = TimingWheel::TimerID;
 
 public:
-    static std::unique_ptr<TaskThread> create(const std::string& prefix);
+    static std::unique_ptr<TaskThread> create(const std::string& prefix,
+                                              const ThreadOptions& options = {});
     ~TaskThread();
-    void post(const Task& task);
-    TimerID post_delay(TimeDelta delta_time, const Task& task);
+    // 不加锁、稳态下不分配内存，可以在任意线程调用. from用来统计慢任务，调用者不用填
+    void post(Task task, const Location& from = Location::current());
+    TimerID post_delay(TimeDelta delta_time, Task task,
+                       const Location& from = Location::current());
     void cancel(TimerID timer);
     bool is_current_thread();
     void wake();
     bool is_running();
+    // 排队时间、执行时间和定时任务迟到的统计，任意线程可读
+    TaskMetrics& metrics() { return metrics_; }
 
     template <typename ReturnT, typename = typename std::enable_if<!std::is_void<ReturnT>::value>::type>
     ReturnT invoke(std::function<ReturnT(void)> func)
@@ -158,7 +243,7 @@ public:
     }
 
 private:
-    TaskThread(const std::string& prfix);
+    TaskThread(const std::string& prfix, const ThreadOptions& options);
     TaskThread(TaskThread&&) = delete;
     TaskThread& operator=(TaskThread&&) = delete;
     TaskThread(TaskThread&) = delete;
@@ -170,21 +255,121 @@ private:
     void unregister_from_thread_watcher();
     void i_am_alive();
     void set_thread_name();
-    void invokeInternal(const Task& task);
-    inline std::deque<Task> get_pending_tasks();
-    inline std::tuple<std::vector<Task>, TimeDelta> get_timeup_delay_tasks();
+    void invokeInternal(Task task);
+    inline size_t run_pending_tasks();
+    inline std::tuple<size_t, TimeDelta> run_timeup_delay_tasks();
 
 private:
     std::string name_;
-    std::deque<Task> tasks_;
-    std::map<Timestamp, Task> delay_tasks_;
+    const ThreadOptions options_;
+    TaskQueue tasks_;
+    EventCount event_;
+    // 只保护定时器，post()不碰这把锁
     std::mutex mutex_;
-    std::condition_variable cv_;
-    std::atomic<bool> wakeup_ { true };
+    TimingWheel delay_tasks_;
+    // 每轮到期的定时任务都放这里，复用内存
+    std::vector<TimingWheel::Expired> expired_tasks_;
+    TaskMetrics metrics_;
+    // 定时器有变化或者wake()，线程睡眠前要重新检查
+    std::atomic<bool> wakeup_ { false };
+    std::atomic<bool> sleeping_ { false };
     std::thread thread_;
     bool started_ = false;
-    bool stoped_ = false;
+    std::atomic<bool> stoped_ { false };
+    ThreadWatcher::SlotID watch_slot_ = ThreadWatcher::kInvalidSlot;
     int64_t last_report_time_;
 };
 
+// 多个组件共用的线程池，线程数默认等于CPU核数. 每个工作线程有自己的无锁任务队列，
+// 自己的队列空了就去别的线程的队列里偷任务. 需要串行执行的组件不要直接用它，用Strand.
+// 工作线程和TaskThread一样会注册到ThreadWatcher，任务不能长时间阻塞.
+class LT_API Executor
+{
+public:
+    using Task = ::ltlib::Task;
+    using TimerID = TimingWheel::TimerID;
+
+public:
+    // 进程内共享的实例，永不析构
+    static Executor* shared();
+    // num_threads为0时取CPU核数，options应用到每个工作线程
+    static std::unique_ptr<Executor> create(const std::string& prefix, size_t num_threads,
+                                            const ThreadOptions& options = {});
+    ~Executor();
+    // 任意线程. 在工作线程里调用时投递到自己的队列
+    void post(Task task);
+    TimerID post_delay(TimeDelta delta_time, Task task);
+    void cancel(TimerID timer);
+    bool is_current_thread() const;
+    size_t size() const { return workers_.size(); }
+
+private:
+    friend class Strand;
+    struct Worker;
+    Executor(const std::string& prefix, size_t num_threads, const ThreadOptions& options);
+    TimerID post_delay(TimeDelta delta_time, Task task, const Location& from,
+                       TimingWheel::Dispatch dispatch, std::shared_ptr<void> target);
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+    void start();
+    void main_loop(size_t index, std::promise<void>& promise);
+    bool run_one();
+    bool try_run(Worker* victim);
+    size_t run_timeup_delay_tasks(Worker* worker);
+    int64_t next_timer_us();
+    void i_am_alive(Worker* worker);
+
+private:
+    std::string prefix_;
+    const ThreadOptions options_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<uint32_t> next_worker_ { 0 };
+    // post()之后加，取出任务之后减. 工作线程睡眠前靠它判断有没有漏掉的任务
+    std::atomic<int64_t> pending_ { 0 };
+    EventCount event_;
+    std::mutex timer_mutex_;
+    TimingWheel delay_tasks_;
+    // 同一时刻只有一个空闲线程按最近的定时器睡眠，其它的睡长一点. 这里记着它醒来的时间，
+    // 0表示没有线程在等定时器. post_delay()插入更早的定时器时才需要叫醒它
+    std::atomic<int64_t> timer_deadline_us_ { 0 };
+    std::atomic<bool> stoped_ { false };
+};
+
+// 挂在Executor上的串行队列. 投递到同一个Strand的任务按顺序执行，不会并发，
+// 但不固定在某个线程上，所以不能依赖thread_local. 用来代替只为了串行化才存在的TaskThread.
+// 析构时会等正在执行的那一批任务结束，还没执行的任务直接丢弃，这点和TaskThread一致.
+class LT_API Strand
+{
+public:
+    using Task = ::ltlib::Task;
+    using TimerID = Executor::TimerID;
+
+public:
+    static std::unique_ptr<Strand> create(Executor* executor, const std::string& name);
+    ~Strand();
+    void post(Task task, const Location& from = Location::current());
+    TimerID post_delay(TimeDelta delta_time, Task task,
+                       const Location& from = Location::current());
+    void cancel(TimerID timer);
+    // 当前线程是否正在执行这个Strand的任务
+    bool is_current_thread() const;
+    // 排队时间从post()算到Strand开始执行它，包含在Executor里排队的时间
+    TaskMetrics& metrics();
+
+private:
+    struct State;
+    Strand(Executor* executor, const std::string& name);
+    Strand(const Strand&) = delete;
+    Strand& operator=(const Strand&) = delete;
+    static void post(const std::shared_ptr<State>& state, Task task, const TaskQueue::Meta& meta);
+    // 定时任务到期时由Executor调用，target是State
+    static void post_expired(const std::shared_ptr<void>& target, Task task, int64_t when_us,
+                             const Location& from);
+    static void run(const std::shared_ptr<State>& state);
+
+private:
+    // 排队中的任务持有State，Strand析构后它们不会访问已经释放的内存
+    std::shared_ptr<State> state_;
+};
+
 } // namespace ltlib
\ No newline at end of file
@@ -0,0 +1,132 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <ltlib/ltlib.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <ltlib/task.h>
+
+namespace ltlib
+{
+
+// 分层时间轮，给TaskThread的定时任务用. 插入、取消都是O(1)，本身不加锁，由调用方保护.
+// 精度是一个tick(1ms)，到期时间向上取整到tick，所以任务只会晚、不会早于指定时间执行.
+// 共4层，每层64个槽，能直接容纳约4.6小时以内的定时器，更远的先挂在最高层，转到时再重新分配.
+class LT_API TimingWheel
+{
+public:
+    using Task = ::ltlib::Task;
+    // 低32位是节点下标，高32位是节点的代数. 节点回收时代数加1，旧ID自然失效，不会误取消别的定时器
+    using TimerID = int64_t;
+    static constexpr int64_t kTickUs = 1'000;
+    // 到期后不直接执行task，而是连同when_us、from一起转投给target(比如Strand).
+    // 不用再包一层lambda，包了Task的lambda放不进Task的内部缓冲
+    using Dispatch = void (*)(const std::shared_ptr<void>& target, Task task, int64_t when_us,
+                              const Location& from);
+
+    struct Expired
+    {
+        Task task;
+        // add()时给的到期时间，没有向上取整
+        int64_t when_us = 0;
+        Location from;
+        Dispatch dispatch = nullptr;
+        std::shared_ptr<void> target;
+    };
+
+public:
+    explicit TimingWheel(int64_t now_us);
+    TimerID add(int64_t when_us, Task task, const Location& from = {}, Dispatch dispatch = nullptr,
+                std::shared_ptr<void> target = nullptr);
+    // 定时器已经执行或已经取消时返回false
+    bool cancel(TimerID id);
+    // 把now_us及以前到期的任务追加到expired
+    void advance(int64_t now_us, std::vector<Expired>& expired);
+    // 下次需要调用advance()的时间. 高层的槽只知道大致范围，所以可能早于真正的到期时间.
+    // 没有定时器时返回空
+    std::optional<int64_t> next_wakeup_us() const;
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 6;
+    static constexpr uint32_t kSlots = 1u << kSlotBits;
+    static constexpr uint32_t kSlotMask = kSlots - 1;
+    // 最后一条链表放已经到期、等待下次advance()取走的定时器
+    static constexpr uint32_t kReadyList = kLevels * kSlots;
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    struct Node
+    {
+        Task task;
+        int64_t when_us = 0;
+        Location from;
+        Dispatch dispatch = nullptr;
+        std::shared_ptr<void> target;
+        int64_t expiry_tick = 0;
+        uint32_t generation = 1;
+        uint32_t list = kNil;
+        uint32_t prev = kNil;
+        uint32_t next = kNil; // 空闲节点借用next串成空闲链表
+    };
+    struct List
+    {
+        uint32_t head = kNil;
+        uint32_t tail = kNil;
+    };
+
+    void place(uint32_t index);
+    void link(uint32_t list, uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(int level);
+    void fire(uint32_t list, std::vector<Expired>& expired);
+    int64_t next_event_tick() const;
+
+private:
+    int64_t current_tick_;
+    std::vector<Node> nodes_;
+    uint32_t free_head_ = kNil;
+    std::array<List, kLevels * kSlots + 1> lists_;
+    // 每层哪些槽非空，用来O(1)找下一个要处理的槽
+    std::array<uint64_t, kLevels> occupied_ {};
+    size_t size_ = 0;
+};
+
+} // namespace ltlib
@@ -0,0 +1,139 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+#include <ltlib/ltlib.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ltlib
+{
+
+// 记录Chrome trace-event格式的事件，dump出来的JSON可以直接用chrome://tracing或Perfetto打开.
+// 每个线程一个无锁环形缓冲区，只保留最近kEventsPerThread个事件，写事件只有几次relaxed原子写.
+// 默认关闭，关闭时每个打点只有一次原子读. 线程第一次在开启状态下打点时才分配缓冲区，
+// 线程退出后缓冲区先保留，缓冲区数量超过kMaxThreadBuffers后才给新线程复用.
+// 事件名必须是字符串字面量或者生命周期覆盖dump()的字符串，记录器只保存指针.
+class LT_API Tracer
+{
+public:
+    static constexpr size_t kEventsPerThread = 4096;
+    static constexpr size_t kMaxThreadBuffers = 32;
+
+public:
+    static Tracer* instance();
+    void enable();
+    void disable();
+    bool is_enabled() const { return enabled_.load(std::memory_order_relaxed); }
+    // 写到path，失败返回false. 可以在记录的同时调用
+    bool dump(const std::string& path);
+
+    // 当前线程在trace里显示的名字，BlockingThread和TaskThread会自动设置
+    static void set_thread_name(const std::string& name);
+
+    void begin(const char* name);
+    void end(const char* name);
+    void counter(const char* name, int64_t value);
+    // 同一个id的flow事件会被连成箭头，用来跟踪一帧在各个线程之间的流转
+    void flow_begin(const char* name, uint64_t id);
+    void flow_step(const char* name, uint64_t id);
+    void flow_end(const char* name, uint64_t id);
+
+private:
+    struct ThreadBuffer;
+    friend struct ThreadBufferHolder;
+
+private:
+    Tracer() = default;
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+    ThreadBuffer* current_buffer(bool create);
+    ThreadBuffer* acquire_buffer();
+    void record(ThreadBuffer* buffer, char phase, const char* name, int64_t arg);
+
+private:
+    std::atomic<bool> enabled_ { false };
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name)
+        : name_ { Tracer::instance()->is_enabled() ? name : nullptr }
+    {
+        if (name_ != nullptr) {
+            Tracer::instance()->begin(name_);
+        }
+    }
+    ~TraceScope()
+    {
+        if (name_ != nullptr) {
+            Tracer::instance()->end(name_);
+        }
+    }
+
+private:
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+};
+
+} // namespace ltlib
+
+#define LT_TRACE_CONCAT_INNER(a, b) a##b
+#define LT_TRACE_CONCAT(a, b) LT_TRACE_CONCAT_INNER(a, b)
+
+#define LT_TRACE_SCOPE(name) ::ltlib::TraceScope LT_TRACE_CONCAT(lt_trace_scope_, __LINE__) { name }
+
+#define LT_TRACE_COUNTER(name, value)                                                              \
+    do {                                                                                           \
+        if (::ltlib::Tracer::instance()->is_enabled()) {                                           \
+            ::ltlib::Tracer::instance()->counter(name, static_cast<int64_t>(value));               \
+        }                                                                                          \
+    } while (0)
+
+#define LT_TRACE_FLOW(kind, name, id)                                                              \
+    do {                                                                                           \
+        if (::ltlib::Tracer::instance()->is_enabled()) {                                           \
+            ::ltlib::Tracer::instance()->kind(name, static_cast<uint64_t>(id));                    \
+        }                                                                                          \
+    } while (0)
+
+#define LT_TRACE_FLOW_BEGIN(name, id) LT_TRACE_FLOW(flow_begin, name, id)
+#define LT_TRACE_FLOW_STEP(name, id) LT_TRACE_FLOW(flow_step, name, id)
+#define LT_TRACE_FLOW_END(name, id) LT_TRACE_FLOW(flow_end, name, id)
@@ -0,0 +1,740 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ltlib/async_log.h>
+
+#if defined(LT_LINUX) || defined(LT_ANDROID)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(LT_ANDROID)
+#include <android/log.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <ltlib/event_count.h>
+#include <ltlib/logging.h>
+
+namespace {
+
+using ltlib::log_detail::Arg;
+using ltlib::log_detail::ArgType;
+
+enum class RecordKind : uint8_t
+{
+    Padding,
+    Printf,
+    Text,
+};
+
+// 缓冲区里的一条日志: RecordHeader + ArgSlot * arg_count + 字符串数据，按8字节对齐
+struct RecordHeader
+{
+    // size和kind在最前面的kAlign字节里
+    uint32_t size;
+    RecordKind kind;
+    uint8_t level;
+    uint16_t arg_count;
+    int64_t timestamp_us;
+    const char* fmt;
+};
+
+struct ArgSlot
+{
+    ArgType type;
+    // String: 字符串数据在记录里的偏移和长度
+    uint32_t offset;
+    uint32_t length;
+    uint64_t value;
+};
+
+constexpr size_t kAlign = 8;
+constexpr size_t kMaxRecordSize = 16 * 1024;
+
+size_t align_up(size_t size)
+{
+    return (size + kAlign - 1) & ~(kAlign - 1);
+}
+
+int64_t steady_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+int64_t current_thread_id()
+{
+#if defined(LT_LINUX) || defined(LT_ANDROID)
+    return static_cast<int64_t>(syscall(SYS_gettid));
+#else
+    return static_cast<int64_t>(std::hash<std::thread::id> {}(std::this_thread::get_id()));
+#endif
+}
+
+char level_char(int level)
+{
+    switch (level) {
+    case ANDROID_LOG_VERBOSE:
+        return 'V';
+    case ANDROID_LOG_DEBUG:
+        return 'D';
+    case ANDROID_LOG_INFO:
+        return 'I';
+    case ANDROID_LOG_WARN:
+        return 'W';
+    case ANDROID_LOG_ERROR:
+        return 'E';
+    case ANDROID_LOG_FATAL:
+        return 'F';
+    default:
+        return '?';
+    }
+}
+
+// 单生产者(所属线程)单消费者(后台线程)的字节环形缓冲区，读写位置单调递增
+struct ThreadRing
+{
+    explicit ThreadRing(size_t size)
+        : capacity { align_up(std::max(size, kMaxRecordSize * 2)) }
+        , data { new uint8_t[capacity] }
+        , tid { current_thread_id() }
+    {
+    }
+    const size_t capacity;
+    std::unique_ptr<uint8_t[]> data;
+    const int64_t tid;
+    alignas(64) std::atomic<uint64_t> head { 0 };
+    alignas(64) std::atomic<uint64_t> tail { 0 };
+    uint64_t cached_head = 0;
+    std::atomic<uint64_t> dropped { 0 };
+    std::atomic<bool> retired { false };
+};
+
+struct Output
+{
+    int64_t timestamp_us;
+    int64_t tid;
+    int level;
+    std::string text;
+};
+
+class Backend
+{
+public:
+    explicit Backend(const ltlib::AsyncLogOptions& options);
+    ~Backend();
+    bool init();
+    void stop();
+    void flush();
+    ThreadRing* ring_for_current_thread();
+    void notify() { event_.notify(); }
+    bool stopped() const { return stoped_.load(std::memory_order_seq_cst); }
+    // 停止之后由写日志的线程调用，同步输出还留在缓冲区里的日志
+    void drain_after_stop();
+
+private:
+    void loop();
+    bool drain_once(std::vector<Output>& outputs);
+    void drain_ring(ThreadRing& ring, std::vector<Output>& outputs);
+
+private:
+    const ltlib::AsyncLogOptions options_;
+    std::FILE* file_ = nullptr;
+    int64_t wall_offset_us_ = 0;
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+    // 停止前只有后台线程取日志，停止后写日志的线程也可能来取，用它保证同一时间只有一个消费者
+    std::mutex drain_mutex_;
+    ltlib::EventCount event_;
+    std::atomic<bool> stoped_ { false };
+    std::mutex flush_mutex_;
+    std::condition_variable flush_cv_;
+    uint64_t flush_requested_ = 0;
+    uint64_t flush_done_ = 0;
+    std::thread thread_;
+};
+
+std::atomic<Backend*> g_backend { nullptr };
+std::mutex g_backend_mutex;
+
+struct RingHolder
+{
+    std::shared_ptr<ThreadRing> ring;
+    Backend* owner = nullptr;
+    ~RingHolder()
+    {
+        if (ring != nullptr) {
+            ring->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local RingHolder t_ring;
+
+void write_console(int level, const char* text)
+{
+#if defined(LT_ANDROID)
+    __android_log_write(level, "ltmsdk", text);
+#else
+    std::fprintf(stderr, "[ltmsdk] %c %s\n", level_char(level), text);
+#endif
+}
+
+void write_file(std::FILE* file, const Output& output, int64_t wall_offset_us)
+{
+    const int64_t wall_us = output.timestamp_us + wall_offset_us;
+    std::time_t seconds = static_cast<std::time_t>(wall_us / 1'000'000);
+    std::tm tm {};
+    localtime_r(&seconds, &tm);
+    std::fprintf(file, "%02d-%02d %02d:%02d:%02d.%03d %6lld %c %s\n", tm.tm_mon + 1, tm.tm_mday,
+                 tm.tm_hour, tm.tm_min, tm.tm_sec, static_cast<int>(wall_us / 1000 % 1000),
+                 static_cast<long long>(output.tid), level_char(output.level),
+                 output.text.c_str());
+}
+
+Backend::Backend(const ltlib::AsyncLogOptions& options)
+    : options_ { options }
+{
+}
+
+Backend::~Backend()
+{
+    if (file_ != nullptr) {
+        std::fclose(file_);
+    }
+}
+
+bool Backend::init()
+{
+    if (!options_.file_path.empty()) {
+        file_ = std::fopen(options_.file_path.c_str(), "a");
+        if (file_ == nullptr) {
+            return false;
+        }
+    }
+    const int64_t wall_now = std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::system_clock::now().time_since_epoch())
+                                 .count();
+    wall_offset_us_ = wall_now - steady_us();
+    thread_ = std::thread { [this]() { loop(); } };
+    return true;
+}
+
+void Backend::stop()
+{
+    stoped_.store(true, std::memory_order_seq_cst);
+    event_.notify();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void Backend::flush()
+{
+    std::unique_lock lock { flush_mutex_ };
+    const uint64_t target = ++flush_requested_;
+    event_.notify();
+    flush_cv_.wait(lock, [this, target]() {
+        return flush_done_ >= target || stoped_.load(std::memory_order_acquire);
+    });
+}
+
+ThreadRing* Backend::ring_for_current_thread()
+{
+    if (t_ring.owner == this) {
+        return t_ring.ring.get();
+    }
+    // 第一次在这个backend上打日志. 之前的backend已经停止，丢掉旧的缓冲区
+    if (t_ring.ring != nullptr) {
+        t_ring.ring->retired.store(true, std::memory_order_release);
+    }
+    auto ring = std::make_shared<ThreadRing>(options_.buffer_size);
+    {
+        std::lock_guard lock { rings_mutex_ };
+        rings_.push_back(ring);
+    }
+    t_ring.ring = ring;
+    t_ring.owner = this;
+    return ring.get();
+}
+
+void Backend::loop()
+{
+    std::vector<Output> outputs;
+    for (;;) {
+        auto key = event_.prepare_wait();
+        bool stop = stoped_.load(std::memory_order_acquire);
+        uint64_t flush_target = 0;
+        {
+            std::lock_guard lock { flush_mutex_ };
+            flush_target = flush_requested_;
+        }
+        bool has_work = drain_once(outputs);
+        if (has_work || stop || flush_target != flush_done_) {
+            event_.cancel_wait();
+        }
+        else {
+            event_.wait_for(key, std::chrono::milliseconds { options_.flush_interval_ms });
+        }
+        if (flush_target != flush_done_) {
+            // drain_once已经取走了请求之前提交的日志
+            std::lock_guard lock { flush_mutex_ };
+            flush_done_ = flush_target;
+            flush_cv_.notify_all();
+        }
+        if (stop) {
+            drain_once(outputs);
+            break;
+        }
+    }
+    std::lock_guard lock { flush_mutex_ };
+    flush_cv_.notify_all();
+}
+
+void Backend::drain_after_stop()
+{
+    std::vector<Output> outputs;
+    drain_once(outputs);
+}
+
+bool Backend::drain_once(std::vector<Output>& outputs)
+{
+    std::lock_guard drain_lock { drain_mutex_ };
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    {
+        std::lock_guard lock { rings_mutex_ };
+        rings = rings_;
+    }
+    outputs.clear();
+    for (auto& ring : rings) {
+        const bool retired = ring->retired.load(std::memory_order_acquire);
+        drain_ring(*ring, outputs);
+        if (uint64_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed)) {
+            outputs.push_back(Output { steady_us(), ring->tid, ANDROID_LOG_WARN,
+                                       std::to_string(dropped) + " log messages dropped" });
+        }
+        if (retired) {
+            std::lock_guard lock { rings_mutex_ };
+            rings_.erase(std::remove(rings_.begin(), rings_.end(), ring), rings_.end());
+        }
+    }
+    if (outputs.empty()) {
+        return false;
+    }
+    // 各线程的缓冲区分别取出，按时间排一下
+    std::stable_sort(outputs.begin(), outputs.end(), [](const Output& a, const Output& b) {
+        return a.timestamp_us < b.timestamp_us;
+    });
+    for (const auto& output : outputs) {
+        if (options_.console) {
+            write_console(output.level, output.text.c_str());
+        }
+        if (file_ != nullptr) {
+            write_file(file_, output, wall_offset_us_);
+        }
+    }
+    if (file_ != nullptr) {
+        std::fflush(file_);
+    }
+    return true;
+}
+
+void Backend::drain_ring(ThreadRing& ring, std::vector<Output>& outputs)
+{
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    // seq_cst: 与publish()里的tail、stoped_一起保证停止时不漏日志
+    const uint64_t tail = ring.tail.load(std::memory_order_seq_cst);
+    Arg args[64];
+    while (head < tail) {
+        const uint8_t* record = ring.data.get() + head % ring.capacity;
+        // padding可能不够一个完整的RecordHeader，先只读size和kind
+        RecordHeader header {};
+        std::memcpy(&header, record, kAlign);
+        if (header.kind != RecordKind::Padding) {
+            std::memcpy(&header, record, sizeof(header));
+            const auto* slots = reinterpret_cast<const ArgSlot*>(record + sizeof(header));
+            const size_t count = std::min<size_t>(header.arg_count, std::size(args));
+            for (size_t i = 0; i < count; i++) {
+                args[i].type = slots[i].type;
+                if (slots[i].type == ArgType::String) {
+                    args[i].s = reinterpret_cast<const char*>(record + slots[i].offset);
+                }
+                else {
+                    args[i].u = slots[i].value;
+                }
+            }
+            Output output { header.timestamp_us, ring.tid, header.level, {} };
+            if (header.kind == RecordKind::Printf) {
+                output.text = ltlib::log_detail::format(header.fmt, args, count);
+            }
+            else {
+                output.text.assign(args[0].s, slots[0].length);
+            }
+            outputs.push_back(std::move(output));
+        }
+        head += header.size;
+    }
+    ring.head.store(head, std::memory_order_release);
+}
+
+// 在本线程的缓冲区里预留size字节，返回写入位置. 空间不够返回nullptr
+uint8_t* reserve(ThreadRing& ring, size_t size, uint64_t& new_tail)
+{
+    const uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    const size_t offset = tail % ring.capacity;
+    const size_t to_end = ring.capacity - offset;
+    // 放不下就在尾部填一条padding，从头开始写
+    const size_t needed = to_end < size ? to_end + size : size;
+    if (tail + needed - ring.cached_head > ring.capacity) {
+        ring.cached_head = ring.head.load(std::memory_order_acquire);
+        if (tail + needed - ring.cached_head > ring.capacity) {
+            return nullptr;
+        }
+    }
+    if (to_end < size) {
+        RecordHeader padding {};
+        padding.size = static_cast<uint32_t>(to_end);
+        padding.kind = RecordKind::Padding;
+        std::memcpy(ring.data.get() + offset, &padding, kAlign);
+        new_tail = tail + needed;
+        return ring.data.get();
+    }
+    new_tail = tail + size;
+    return ring.data.get() + offset;
+}
+
+void publish(ThreadRing& ring, uint64_t new_tail, Backend& backend)
+{
+    const uint64_t head = ring.cached_head;
+    ring.tail.store(new_tail, std::memory_order_seq_cst);
+    // 超过一半才唤醒后台线程，平时靠它定时检查，省掉唤醒的系统调用
+    if (new_tail - head > ring.capacity / 2) {
+        ring.cached_head = ring.head.load(std::memory_order_acquire);
+        if (new_tail - ring.cached_head > ring.capacity / 2) {
+            backend.notify();
+        }
+    }
+}
+
+void write_sync(int level, const std::string& text)
+{
+    write_console(level, text.c_str());
+}
+
+// 返回false表示没有走异步路径，需要同步输出
+bool write_async(int level, RecordKind kind, const char* fmt, const Arg* args, size_t count,
+                 const size_t* lengths)
+{
+    Backend* backend = g_backend.load(std::memory_order_acquire);
+    if (backend == nullptr || level >= ANDROID_LOG_FATAL) {
+        return false;
+    }
+    size_t strings = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (args[i].type == ArgType::String) {
+            strings += lengths[i] + 1;
+        }
+    }
+    const size_t size =
+        align_up(sizeof(RecordHeader) + sizeof(ArgSlot) * count + strings);
+    if (size > kMaxRecordSize || count > 64) {
+        return false;
+    }
+    ThreadRing* ring = backend->ring_for_current_thread();
+    uint64_t new_tail = 0;
+    uint8_t* record = reserve(*ring, size, new_tail);
+    if (record == nullptr) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    RecordHeader header {};
+    header.size = static_cast<uint32_t>(size);
+    header.kind = kind;
+    header.level = static_cast<uint8_t>(level);
+    header.arg_count = static_cast<uint16_t>(count);
+    header.timestamp_us = steady_us();
+    header.fmt = fmt;
+    std::memcpy(record, &header, sizeof(header));
+    auto* slots = reinterpret_cast<ArgSlot*>(record + sizeof(header));
+    uint32_t string_offset = static_cast<uint32_t>(sizeof(header) + sizeof(ArgSlot) * count);
+    for (size_t i = 0; i < count; i++) {
+        slots[i].type = args[i].type;
+        if (args[i].type == ArgType::String) {
+            slots[i].offset = string_offset;
+            slots[i].length = static_cast<uint32_t>(lengths[i]);
+            std::memcpy(record + string_offset, args[i].s, lengths[i]);
+            record[string_offset + lengths[i]] = '\0';
+            string_offset += static_cast<uint32_t>(lengths[i] + 1);
+        }
+        else {
+            slots[i].value = args[i].u;
+        }
+    }
+    publish(*ring, new_tail, *backend);
+    // 后台线程最后一次取日志之后才提交的，由本线程自己输出. tail和stoped_都是seq_cst，
+    // 要么这里看到已停止，要么后台线程最后一次取日志时能看到这条
+    if (backend->stopped()) {
+        backend->drain_after_stop();
+    }
+    return true;
+}
+
+// 从fmt里取出一个转换说明，spec不含长度修饰符，返回转换字符，fmt指向说明之后
+char parse_spec(const char*& fmt, std::string& spec, bool& star_width, bool& star_precision)
+{
+    spec = "%";
+    star_width = false;
+    star_precision = false;
+    while (*fmt != '\0' && std::strchr("-+ #0", *fmt) != nullptr) {
+        spec.push_back(*fmt++);
+    }
+    if (*fmt == '*') {
+        star_width = true;
+        spec.push_back(*fmt++);
+    }
+    while (*fmt >= '0' && *fmt <= '9') {
+        spec.push_back(*fmt++);
+    }
+    if (*fmt == '.') {
+        spec.push_back(*fmt++);
+        if (*fmt == '*') {
+            star_precision = true;
+            spec.push_back(*fmt++);
+        }
+        while (*fmt >= '0' && *fmt <= '9') {
+            spec.push_back(*fmt++);
+        }
+    }
+    while (*fmt != '\0' && std::strchr("hljztL", *fmt) != nullptr) {
+        fmt++;
+    }
+    return *fmt == '\0' ? '\0' : *fmt++;
+}
+
+template <typename... T> void append_formatted(std::string& out, const char* spec, T... values)
+{
+    char buffer[256];
+    int n = std::snprintf(buffer, sizeof(buffer), spec, values...);
+    if (n < 0) {
+        return;
+    }
+    if (static_cast<size_t>(n) < sizeof(buffer)) {
+        out.append(buffer, n);
+        return;
+    }
+    std::string large(static_cast<size_t>(n) + 1, '\0');
+    std::snprintf(large.data(), large.size(), spec, values...);
+    out.append(large.data(), n);
+}
+
+int64_t as_int(const Arg& arg)
+{
+    return arg.type == ArgType::Double ? static_cast<int64_t>(arg.d) : arg.i;
+}
+
+double as_double(const Arg& arg)
+{
+    switch (arg.type) {
+    case ArgType::Double:
+        return arg.d;
+    case ArgType::Int:
+        return static_cast<double>(arg.i);
+    default:
+        return static_cast<double>(arg.u);
+    }
+}
+
+} // namespace
+
+namespace ltlib
+{
+
+bool start_async_logging(const AsyncLogOptions& options)
+{
+    std::lock_guard lock { g_backend_mutex };
+    if (g_backend.load(std::memory_order_relaxed) != nullptr) {
+        return true;
+    }
+    auto backend = new Backend { options };
+    if (!backend->init()) {
+        delete backend;
+        LOG(ERR) << "Start async logging failed, open '" << options.file_path << "' failed";
+        return false;
+    }
+    g_backend.store(backend, std::memory_order_release);
+    return true;
+}
+
+void stop_async_logging()
+{
+    std::lock_guard lock { g_backend_mutex };
+    Backend* backend = g_backend.exchange(nullptr, std::memory_order_acq_rel);
+    if (backend != nullptr) {
+        backend->stop();
+        // 其它线程可能还拿着指针正在写，backend不释放. 它们在后台线程退出后才提交的日志
+        // 由它们自己同步输出，见write_async()
+    }
+}
+
+void flush_logs()
+{
+    Backend* backend = g_backend.load(std::memory_order_acquire);
+    if (backend != nullptr) {
+        backend->flush();
+    }
+}
+
+namespace log_detail
+{
+
+void log_printf(int level, const char* fmt, const Arg* args, size_t count)
+{
+    size_t lengths[64];
+    const size_t n = std::min<size_t>(count, std::size(lengths));
+    for (size_t i = 0; i < n; i++) {
+        if (args[i].type == ArgType::String) {
+            lengths[i] = std::strlen(args[i].s);
+        }
+    }
+    if (count <= std::size(lengths) &&
+        write_async(level, RecordKind::Printf, fmt, args, count, lengths)) {
+        return;
+    }
+    flush_logs();
+    write_sync(level, format(fmt, args, count));
+}
+
+void log_text(int level, const char* text, size_t size)
+{
+    Arg arg;
+    arg.type = ArgType::String;
+    arg.s = text;
+    if (write_async(level, RecordKind::Text, nullptr, &arg, 1, &size)) {
+        return;
+    }
+    flush_logs();
+    write_sync(level, std::string { text, size });
+}
+
+std::string format(const char* fmt, const Arg* args, size_t count)
+{
+    std::string out;
+    std::string spec;
+    size_t next = 0;
+    auto take = [&]() -> Arg {
+        return next < count ? args[next++] : Arg {};
+    };
+    while (*fmt != '\0') {
+        const char* percent = std::strchr(fmt, '%');
+        if (percent == nullptr) {
+            out.append(fmt);
+            break;
+        }
+        out.append(fmt, percent - fmt);
+        fmt = percent + 1;
+        if (*fmt == '%') {
+            out.push_back('%');
+            fmt++;
+            continue;
+        }
+        bool star_width = false;
+        bool star_precision = false;
+        const char conversion = parse_spec(fmt, spec, star_width, star_precision);
+        if (conversion == '\0') {
+            break;
+        }
+        // 不支持*宽度，取掉参数后当作没有
+        if (star_width || star_precision) {
+            spec.erase(std::remove(spec.begin(), spec.end(), '*'), spec.end());
+            if (star_width) {
+                take();
+            }
+            if (star_precision) {
+                take();
+            }
+        }
+        const Arg arg = take();
+        switch (conversion) {
+        case 'd':
+        case 'i':
+            append_formatted(out, (spec + "lld").c_str(), static_cast<long long>(as_int(arg)));
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            append_formatted(out, (spec + "ll" + conversion).c_str(),
+                             static_cast<unsigned long long>(as_int(arg)));
+            break;
+        case 'c':
+            append_formatted(out, (spec + 'c').c_str(), static_cast<int>(as_int(arg)));
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            append_formatted(out, (spec + conversion).c_str(), as_double(arg));
+            break;
+        case 's':
+            append_formatted(out, (spec + 's').c_str(),
+                             arg.type == ArgType::String ? arg.s : "(?)");
+            break;
+        case 'p':
+            append_formatted(out, (spec + 'p').c_str(), arg.p);
+            break;
+        default:
+            out.push_back('%');
+            out.push_back(conversion);
+            break;
+        }
+    }
+    return out;
+}
+
+} // namespace log_detail
+
+} // namespace ltlib
@@ -0,0 +1,122 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ltlib/event_count.h>
+
+#if defined(LT_LINUX) || defined(LT_ANDROID)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace ltlib {
+
+EventCount::Key EventCount::prepare_wait() {
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    return seq_.load(std::memory_order_seq_cst);
+}
+
+void EventCount::cancel_wait() {
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+#if defined(LT_LINUX) || defined(LT_ANDROID)
+
+bool EventCount::wait_for(Key key, std::chrono::microseconds timeout) {
+    struct timespec ts {};
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1'000'000);
+    ts.tv_nsec = static_cast<long>(timeout.count() % 1'000'000 * 1'000);
+    // seq_已经变了，futex会立刻返回EAGAIN
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq_), FUTEX_WAIT_PRIVATE, key, &ts, nullptr,
+            0);
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+    return seq_.load(std::memory_order_acquire) != key;
+}
+
+void EventCount::notify() {
+    // 与prepare_wait()配对，保证“生产者入队”和“消费者登记等待”至少有一方能看到对方
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    seq_.fetch_add(1, std::memory_order_release);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq_), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr,
+            nullptr, 0);
+}
+
+void EventCount::notify_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    // 还没进入futex的等待者看到seq_变化会直接返回，已经睡下的只唤醒一个
+    seq_.fetch_add(1, std::memory_order_release);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq_), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr,
+            0);
+}
+
+#else
+
+bool EventCount::wait_for(Key key, std::chrono::microseconds timeout) {
+    std::unique_lock lock{mutex_};
+    bool notified = cv_.wait_for(
+        lock, timeout, [this, key]() { return seq_.load(std::memory_order_relaxed) != key; });
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+    return notified;
+}
+
+void EventCount::notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    {
+        std::lock_guard lock{mutex_};
+        seq_.fetch_add(1, std::memory_order_release);
+    }
+    cv_.notify_all();
+}
+
+void EventCount::notify_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    {
+        std::lock_guard lock{mutex_};
+        seq_.fetch_add(1, std::memory_order_release);
+    }
+    cv_.notify_one();
+}
+
+#endif
+
+} // namespace ltlib
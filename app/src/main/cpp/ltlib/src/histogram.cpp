@@ -0,0 +1,198 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ltlib/histogram.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+// v必须大于0
+size_t highest_bit(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanReverse64(&index, v);
+    return index;
+#else
+    return 63 - static_cast<size_t>(__builtin_clzll(v));
+#endif
+}
+
+} // namespace
+
+namespace ltlib {
+
+size_t Histogram::bucket_index(int64_t value) {
+    if (value < static_cast<int64_t>(kLinearBuckets)) {
+        return value < 0 ? 0 : static_cast<size_t>(value);
+    }
+    const auto v = static_cast<uint64_t>(value);
+    const size_t exponent = highest_bit(v);
+    if (exponent >= kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    const size_t sub = (v >> (exponent - kSubBucketBits)) & ((1 << kSubBucketBits) - 1);
+    return kLinearBuckets + ((exponent - 4) << kSubBucketBits) + sub;
+}
+
+int64_t Histogram::bucket_upper_bound(size_t index) {
+    if (index < kLinearBuckets) {
+        return static_cast<int64_t>(index);
+    }
+    const size_t exponent = ((index - kLinearBuckets) >> kSubBucketBits) + 4;
+    const size_t sub = (index - kLinearBuckets) & ((1 << kSubBucketBits) - 1);
+    const int64_t width = int64_t{1} << (exponent - kSubBucketBits);
+    return ((int64_t{1} << kSubBucketBits) + static_cast<int64_t>(sub)) * width + width - 1;
+}
+
+void Histogram::record(int64_t value) {
+    buckets_[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    int64_t old_max = max_.load(std::memory_order_relaxed);
+    while (value > old_max &&
+           !max_.compare_exchange_weak(old_max, value, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::merge(const Histogram& other) {
+    for (size_t i = 0; i < kBucketCount; i++) {
+        uint32_t n = other.buckets_[i].load(std::memory_order_relaxed);
+        if (n != 0) {
+            buckets_[i].fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+    count_.fetch_add(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    int64_t other_max = other.max_.load(std::memory_order_relaxed);
+    int64_t old_max = max_.load(std::memory_order_relaxed);
+    while (other_max > old_max &&
+           !max_.compare_exchange_weak(old_max, other_max, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::count() const {
+    return count_.load(std::memory_order_relaxed);
+}
+
+int64_t Histogram::max() const {
+    return max_.load(std::memory_order_relaxed);
+}
+
+int64_t Histogram::percentile(double p) const {
+    // 并发record时count_和桶可能对不上，以桶里的实际数量为准
+    uint64_t total = 0;
+    std::array<uint32_t, kBucketCount> snapshot;
+    for (size_t i = 0; i < kBucketCount; i++) {
+        snapshot[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += snapshot[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    p = std::clamp(p, 0.0, 100.0);
+    auto rank = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total)));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; i++) {
+        seen += snapshot[i];
+        if (seen >= rank) {
+            // 最高的桶可能比实际最大值宽，不超过记录到的最大值
+            return std::min(bucket_upper_bound(i), std::max(max(), int64_t{0}));
+        }
+    }
+    return max();
+}
+
+void WindowedHistogram::record(int64_t value, int64_t now_us) {
+    rotate(now_us);
+    Tier& tier = tiers_[0];
+    tier.histograms[tier.current].record(value);
+}
+
+WindowedHistogram::Summary WindowedHistogram::summary(Window window, int64_t now_us) {
+    const Histogram& histogram = select(window, now_us);
+    Summary result;
+    result.count = histogram.count();
+    result.p50 = histogram.percentile(50);
+    result.p90 = histogram.percentile(90);
+    result.p99 = histogram.percentile(99);
+    result.p999 = histogram.percentile(99.9);
+    result.max = histogram.max();
+    return result;
+}
+
+void WindowedHistogram::merge_into(Window window, int64_t now_us, Histogram& out) {
+    out.merge(select(window, now_us));
+}
+
+const Histogram& WindowedHistogram::select(Window window, int64_t now_us) {
+    rotate(now_us);
+    // 刚开始统计、还没有完整窗口时，退而用正在累积的窗口
+    const Tier& tier = tiers_[static_cast<size_t>(window)];
+    const Histogram& last = tier.histograms[tier.current ^ 1];
+    return last.count() != 0 ? last : tier.histograms[tier.current];
+}
+
+void WindowedHistogram::rotate(int64_t now_us) {
+    for (size_t i = 0; i < kWindowCount; i++) {
+        Tier& tier = tiers_[i];
+        const int64_t id = now_us / tier.period_us;
+        if (tier.id == id) {
+            // 小的一档没有轮换，大的也不会
+            return;
+        }
+        Histogram& finished = tier.histograms[tier.current];
+        if (i + 1 < kWindowCount) {
+            Tier& next = tiers_[i + 1];
+            next.histograms[next.current].merge(finished);
+        }
+        tier.current ^= 1;
+        tier.histograms[tier.current].reset();
+        if (tier.id + 1 != id) {
+            // 中间跳过了整个窗口，最近一个完整窗口是空的
+            finished.reset();
+        }
+        tier.id = id;
+    }
+}
+
+} // namespace ltlib
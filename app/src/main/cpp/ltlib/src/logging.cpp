@@ -31,6 +31,7 @@
 #include <map>
 
 #include <ltlib/logging.h>
+#include <ltlib/times.h>
 
 namespace {
 int8_t levels[ANDROID_LOG_SILENT + 1] = {1, 1, 1, 1, 1, 1, 1, 1, 1};
@@ -46,8 +47,9 @@ LogCapture::LogCapture(const char* file, const int line, const char* function,
     , _level{level} {}
 
 LogCapture::~LogCapture() {
-    // TODO: 进一步可以用上_file _line _function
-    __android_log_write(_level, "ltmsdk", _stream.str().c_str());
+    // TODO: 进一步可以用上_function
+    const std::string text = _stream.str();
+    log_detail::log_text(_level, text.data(), text.size());
 }
 
 bool logLevel(const android_LogPriority& level) {
@@ -62,4 +64,14 @@ void enableLogLevel(const android_LogPriority& level) {
     levels[level] = 1;
 }
 
+bool LogEveryT::check(double seconds) {
+    const int64_t now = steady_now_ms();
+    int64_t last = last_ms_.load(std::memory_order_relaxed);
+    if (last >= 0 && now - last < static_cast<int64_t>(seconds * 1000)) {
+        return false;
+    }
+    // 多个线程同时到期时只有一个打印
+    return last_ms_.compare_exchange_strong(last, now, std::memory_order_relaxed);
+}
+
 } // namespace ltlib
\ No newline at end of file
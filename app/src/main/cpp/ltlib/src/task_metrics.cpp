@@ -0,0 +1,141 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ltlib/task_metrics.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include <ltlib/logging.h>
+
+namespace {
+
+ltlib::TaskMetrics::Distribution takeDistribution(ltlib::Histogram& histogram) {
+    ltlib::TaskMetrics::Distribution dist;
+    dist.count = histogram.count();
+    dist.p50 = histogram.percentile(50);
+    dist.p99 = histogram.percentile(99);
+    dist.max = histogram.max();
+    histogram.reset();
+    return dist;
+}
+
+// __builtin_FILE()给的是完整路径，只留文件名
+const char* baseName(const char* path) {
+    if (path == nullptr) {
+        return "?";
+    }
+    const char* slash = std::strrchr(path, '/');
+    const char* backslash = std::strrchr(path, '\\');
+    const char* sep = slash > backslash ? slash : backslash;
+    return sep == nullptr ? path : sep + 1;
+}
+
+std::string locationString(const ltlib::Location& from) {
+    std::ostringstream oss;
+    oss << baseName(from.file) << ':' << from.line;
+    return oss.str();
+}
+
+void printDistribution(std::ostream& os, const char* name,
+                       const ltlib::TaskMetrics::Distribution& dist) {
+    os << name << "{n:" << dist.count << ", p50:" << dist.p50 << ", p99:" << dist.p99
+       << ", max:" << dist.max << '}';
+}
+
+} // namespace
+
+namespace ltlib {
+
+void TaskMetrics::set_slow_task_threshold(int64_t us) {
+    slow_task_us_.store(us, std::memory_order_relaxed);
+}
+
+void TaskMetrics::record(const Location& from, int64_t queue_wait_us, int64_t run_us) {
+    queue_wait_us_.record(queue_wait_us);
+    run_us_.record(run_us);
+    const int64_t threshold = slow_task_us_.load(std::memory_order_relaxed);
+    if (queue_wait_us >= threshold || run_us >= threshold) {
+        record_slow(SlowTask{from, false, queue_wait_us, run_us});
+    }
+}
+
+void TaskMetrics::record_delayed(const Location& from, int64_t late_us, int64_t run_us) {
+    delay_late_us_.record(late_us);
+    run_us_.record(run_us);
+    const int64_t threshold = slow_task_us_.load(std::memory_order_relaxed);
+    if (late_us >= threshold || run_us >= threshold) {
+        record_slow(SlowTask{from, true, late_us, run_us});
+    }
+}
+
+void TaskMetrics::record_slow(const SlowTask& task) {
+    {
+        std::lock_guard lock{mutex_};
+        slow_tasks_[slow_task_count_ % kMaxSlowTasks] = task;
+        slow_task_count_++;
+    }
+    LOG_EVERY_T(WARNING, 1) << "Slow " << (task.delayed ? "delayed task " : "task ")
+                            << locationString(task.from) << (task.delayed ? " late:" : " wait:")
+                            << task.wait_us << "us, run:" << task.run_us << "us";
+}
+
+TaskMetrics::Snapshot TaskMetrics::collect() {
+    Snapshot snapshot;
+    snapshot.queue_wait_us = takeDistribution(queue_wait_us_);
+    snapshot.run_us = takeDistribution(run_us_);
+    snapshot.delay_late_us = takeDistribution(delay_late_us_);
+    std::lock_guard lock{mutex_};
+    snapshot.slow_task_count = slow_task_count_;
+    const uint64_t kept = std::min<uint64_t>(slow_task_count_, kMaxSlowTasks);
+    for (uint64_t i = slow_task_count_ - kept; i < slow_task_count_; i++) {
+        snapshot.slow_tasks.push_back(slow_tasks_[i % kMaxSlowTasks]);
+    }
+    slow_task_count_ = 0;
+    return snapshot;
+}
+
+std::string TaskMetrics::Snapshot::toString() const {
+    std::ostringstream oss;
+    printDistribution(oss, "wait_us", queue_wait_us);
+    oss << ", ";
+    printDistribution(oss, "run_us", run_us);
+    oss << ", ";
+    printDistribution(oss, "late_us", delay_late_us);
+    oss << ", slow:" << slow_task_count;
+    for (const auto& task : slow_tasks) {
+        oss << "\n    " << locationString(task.from) << (task.delayed ? " late:" : " wait:")
+            << task.wait_us << "us, run:" << task.run_us << "us";
+    }
+    return oss.str();
+}
+
+} // namespace ltlib
@@ -0,0 +1,147 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ltlib/task_queue.h>
+
+namespace {
+
+constexpr uint64_t makeTop(uint64_t tag, uint32_t index) {
+    return (tag << 32) | index;
+}
+
+constexpr uint32_t topIndex(uint64_t top) {
+    return static_cast<uint32_t>(top);
+}
+
+constexpr uint64_t topTag(uint64_t top) {
+    return top >> 32;
+}
+
+} // namespace
+
+namespace ltlib {
+
+TaskQueue::~TaskQueue() {
+    Task task;
+    while (!empty()) {
+        pop(task);
+    }
+    for (uint32_t i = 0; i < chunk_count_; i++) {
+        delete[] chunks_[i].load(std::memory_order_relaxed);
+    }
+}
+
+void TaskQueue::push(Task task, const Meta& meta) {
+    Node* node = acquire();
+    node->task = std::move(task);
+    node->meta = meta;
+    queue_.push(node);
+}
+
+bool TaskQueue::pop(Task& task) {
+    Meta meta;
+    return pop(task, meta);
+}
+
+bool TaskQueue::pop(Task& task, Meta& meta) {
+    Node* node = queue_.pop();
+    if (node == nullptr) {
+        return false;
+    }
+    task = std::move(node->task);
+    meta = node->meta;
+    release(node);
+    return true;
+}
+
+bool TaskQueue::empty() const {
+    return queue_.empty();
+}
+
+TaskQueue::Node* TaskQueue::acquire() {
+    uint64_t top = free_top_.load(std::memory_order_acquire);
+    while (topIndex(top) != kNil) {
+        Node* node = node_at(topIndex(top));
+        // node可能已经被别的线程取走并改写了next_free，这种情况下版本号变了，CAS会失败
+        const uint32_t next = node->next_free.load(std::memory_order_relaxed);
+        if (free_top_.compare_exchange_weak(top, makeTop(topTag(top) + 1, next),
+                                            std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+            return node;
+        }
+    }
+    return grow();
+}
+
+TaskQueue::Node* TaskQueue::grow() {
+    std::lock_guard lock{grow_mutex_};
+    if (chunk_count_ == kMaxChunks) {
+        auto node = new Node;
+        node->index = kHeapNode;
+        return node;
+    }
+    const uint32_t base = chunk_count_ << kChunkBits;
+    Node* chunk = new Node[kChunkSize];
+    for (uint32_t i = 0; i < kChunkSize; i++) {
+        chunk[i].index = base + i;
+        chunk[i].next_free.store(base + i + 1, std::memory_order_relaxed);
+    }
+    chunks_[chunk_count_].store(chunk, std::memory_order_release);
+    chunk_count_++;
+    // 第0个直接返回，其余的整串挂到空闲栈上
+    Node* first = &chunk[1];
+    Node* last = &chunk[kChunkSize - 1];
+    uint64_t top = free_top_.load(std::memory_order_relaxed);
+    do {
+        last->next_free.store(topIndex(top), std::memory_order_relaxed);
+    } while (!free_top_.compare_exchange_weak(top, makeTop(topTag(top) + 1, first->index),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+    return &chunk[0];
+}
+
+void TaskQueue::release(Node* node) {
+    if (node->index == kHeapNode) {
+        delete node;
+        return;
+    }
+    uint64_t top = free_top_.load(std::memory_order_relaxed);
+    do {
+        node->next_free.store(topIndex(top), std::memory_order_relaxed);
+    } while (!free_top_.compare_exchange_weak(top, makeTop(topTag(top) + 1, node->index),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+}
+
+TaskQueue::Node* TaskQueue::node_at(uint32_t index) const {
+    return &chunks_[index >> kChunkBits].load(std::memory_order_acquire)[index & (kChunkSize - 1)];
+}
+
+} // namespace ltlib
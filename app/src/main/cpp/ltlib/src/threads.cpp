@@ -31,15 +31,25 @@
 #if defined(LT_WINDOWS)
 #include <Windows.h>
 #elif defined(LT_LINUX) || defined(LT_ANDROID)
+#include <pthread.h>
+#include <sched.h>
 #include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #endif
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
 #include <sstream>
 #include <atomic>
 
 #include <ltlib/logging.h>
 #include <ltlib/threads.h>
 #include <ltlib/times.h>
+#include <ltlib/trace.h>
 #include <ltlib/pragma_warning.h>
 
 namespace {
@@ -92,6 +102,79 @@ void set_current_thread_name(const char* name) {
 #endif
 }
 
+// 当前线程所属的Executor和它在其中的下标，以及正在执行的Strand
+thread_local ltlib::Executor* g_current_executor = nullptr;
+thread_local size_t g_current_worker = 0;
+thread_local const void* g_current_strand = nullptr;
+
+struct CoreMasks
+{
+    uint64_t big = 0;
+    uint64_t little = 0;
+};
+
+// 读不到返回0
+int64_t read_cpu_value(int cpu, const char* file) {
+    std::stringstream ss;
+    ss << "/sys/devices/system/cpu/cpu" << cpu << '/' << file;
+    std::ifstream in{ss.str()};
+    int64_t value = 0;
+    if (!(in >> value)) {
+        return 0;
+    }
+    return value;
+}
+
+CoreMasks detect_core_masks() {
+    constexpr int kMaxCpus = 64;
+    int64_t capacities[kMaxCpus] = {};
+    int count = 0;
+    for (const char* file : {"cpu_capacity", "cpufreq/cpuinfo_max_freq"}) {
+        count = 0;
+        for (int cpu = 0; cpu < kMaxCpus; cpu++) {
+            capacities[cpu] = read_cpu_value(cpu, file);
+            if (capacities[cpu] > 0) {
+                count = cpu + 1;
+            }
+        }
+        if (count > 0) {
+            break;
+        }
+    }
+    CoreMasks masks;
+    if (count == 0) {
+        return masks;
+    }
+    int64_t min_capacity = INT64_MAX;
+    for (int cpu = 0; cpu < count; cpu++) {
+        if (capacities[cpu] > 0) {
+            min_capacity = std::min(min_capacity, capacities[cpu]);
+        }
+    }
+    for (int cpu = 0; cpu < count; cpu++) {
+        if (capacities[cpu] == 0) {
+            // 离线的核读不到，不放进任何掩码
+            continue;
+        }
+        if (capacities[cpu] > min_capacity) {
+            masks.big |= uint64_t{1} << cpu;
+        }
+        else {
+            masks.little |= uint64_t{1} << cpu;
+        }
+    }
+    if (masks.big == 0) {
+        // 所有核一样
+        masks.big = masks.little;
+    }
+    return masks;
+}
+
+const CoreMasks& core_masks() {
+    static const CoreMasks masks = detect_core_masks();
+    return masks;
+}
+
 void crash_me() {
 WARNING_DISABLE(6011)
     int* a = 0;
@@ -105,6 +188,89 @@ namespace ltlib {
 
 using namespace time;
 
+uint64_t big_cores_mask() {
+    return core_masks().big;
+}
+
+uint64_t little_cores_mask() {
+    return core_masks().little;
+}
+
+bool apply_thread_options(const ThreadOptions& options) {
+    uint64_t mask = options.affinity_mask;
+    if (options.cores != ThreadOptions::Cores::Any) {
+        const uint64_t cores =
+            options.cores == ThreadOptions::Cores::Big ? big_cores_mask() : little_cores_mask();
+        if (mask == 0) {
+            mask = cores;
+        }
+        else if ((mask & cores) != 0) {
+            mask &= cores;
+        }
+    }
+#if defined(LT_LINUX) || defined(LT_ANDROID)
+    bool success = true;
+    const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    switch (options.policy) {
+    case ThreadOptions::Policy::Keep:
+        break;
+    case ThreadOptions::Policy::Normal:
+    {
+        sched_param param{};
+        if (sched_setscheduler(0, SCHED_OTHER, &param) != 0) {
+            LOG(WARNING) << "sched_setscheduler(SCHED_OTHER) failed: " << strerror(errno);
+            success = false;
+        }
+        break;
+    }
+    case ThreadOptions::Policy::Fifo:
+    case ThreadOptions::Policy::RoundRobin:
+    {
+        const int policy =
+            options.policy == ThreadOptions::Policy::Fifo ? SCHED_FIFO : SCHED_RR;
+        sched_param param{};
+        param.sched_priority = options.priority.value_or(1);
+        // 安卓上普通应用一般没有CAP_SYS_NICE，会失败
+        int ret = pthread_setschedparam(pthread_self(), policy, &param);
+        if (ret != 0) {
+            LOG(WARNING) << "pthread_setschedparam(" << policy << ", " << param.sched_priority
+                         << ") failed: " << strerror(ret);
+            success = false;
+        }
+        break;
+    }
+    }
+    const bool realtime = options.policy == ThreadOptions::Policy::Fifo ||
+                          options.policy == ThreadOptions::Policy::RoundRobin;
+    if (options.priority.has_value() && !realtime) {
+        // Linux的nice是线程级的，对tid设置只影响当前线程
+        if (setpriority(PRIO_PROCESS, static_cast<id_t>(tid), options.priority.value()) != 0) {
+            LOG(WARNING) << "setpriority(" << options.priority.value()
+                         << ") failed: " << strerror(errno);
+            success = false;
+        }
+    }
+    if (mask != 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu = 0; cpu < 64; cpu++) {
+            if (mask & (uint64_t{1} << cpu)) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        if (sched_setaffinity(tid, sizeof(set), &set) != 0) {
+            LOG(WARNING) << "sched_setaffinity(0x" << std::hex << mask << std::dec
+                         << ") failed: " << strerror(errno);
+            success = false;
+        }
+    }
+    return success;
+#else
+    return options.policy == ThreadOptions::Policy::Keep && !options.priority.has_value() &&
+           mask == 0;
+#endif
+}
+
 ThreadWatcher* ThreadWatcher::instance() {
     static ThreadWatcher* const thread_watcher = new ThreadWatcher;
     return thread_watcher;
@@ -122,16 +288,65 @@ ThreadWatcher::~ThreadWatcher() {
     thread_.join();
 }
 
-void ThreadWatcher::add(const std::string& name, std::thread::id thread_id) {
-    // 由调用者保证name的唯一性
-    ThreadInfo info{name, thread_id, ltlib::steady_now_ms()};
+ThreadWatcher::SlotID ThreadWatcher::add(const std::string& name, std::thread::id thread_id) {
     std::lock_guard lock{mutex_};
-    threads_[name] = info;
+    for (size_t i = 0; i < kMaxThreads; i++) {
+        if (heartbeats_[i].in_use.load(std::memory_order_relaxed)) {
+            continue;
+        }
+        infos_[i].name = name;
+        infos_[i].thread_id = thread_id;
+        infos_[i].stall_ms.reset();
+        heartbeats_[i].last_active_ms.store(ltlib::steady_now_ms(), std::memory_order_relaxed);
+        heartbeats_[i].in_use.store(true, std::memory_order_release);
+        return static_cast<SlotID>(i);
+    }
+    LOG(WARNING) << "ThreadWatcher slots exhausted, '" << name.c_str() << "' won't be watched";
+    return kInvalidSlot;
 }
 
-void ThreadWatcher::remove(const std::string& name) {
+void ThreadWatcher::remove(SlotID slot) {
+    if (slot < 0 || static_cast<size_t>(slot) >= kMaxThreads) {
+        return;
+    }
+    StallStat stat = stallStat(slot);
+    LOG(INFO) << "Thread '" << stat.name.c_str() << "' heartbeat gap(ms) count:" << stat.count
+              << ", p50:" << stat.p50 << ", p99:" << stat.p99 << ", max:" << stat.max;
     std::lock_guard lock{mutex_};
-    threads_.erase(name);
+    heartbeats_[slot].in_use.store(false, std::memory_order_release);
+}
+
+void ThreadWatcher::reportAlive(SlotID slot, int64_t now_ms) {
+    if (slot < 0 || static_cast<size_t>(slot) >= kMaxThreads) {
+        return;
+    }
+    // 只有本线程写这个槽，读-写不需要原子RMW
+    auto& heartbeat = heartbeats_[slot];
+    const int64_t last = heartbeat.last_active_ms.load(std::memory_order_relaxed);
+    heartbeat.last_active_ms.store(now_ms, std::memory_order_relaxed);
+    infos_[slot].stall_ms.record(now_ms - last);
+}
+
+std::vector<ThreadWatcher::StallStat> ThreadWatcher::stallStats() {
+    std::vector<StallStat> stats;
+    for (size_t i = 0; i < kMaxThreads; i++) {
+        if (heartbeats_[i].in_use.load(std::memory_order_acquire)) {
+            stats.push_back(stallStat(static_cast<SlotID>(i)));
+        }
+    }
+    return stats;
+}
+
+ThreadWatcher::StallStat ThreadWatcher::stallStat(SlotID slot) {
+    const Histogram& histogram = infos_[slot].stall_ms;
+    StallStat stat;
+    stat.count = histogram.count();
+    stat.p50 = histogram.percentile(50);
+    stat.p99 = histogram.percentile(99);
+    stat.max = histogram.max();
+    std::lock_guard lock{mutex_};
+    stat.name = infos_[slot].name;
+    return stat;
 }
 
 void ThreadWatcher::registerTerminateCallback(
@@ -154,10 +369,13 @@ void ThreadWatcher::checkLoop() {
     int64_t next_sleep_ms = 700;
     constexpr int64_t kOneMinute = 60'000;
     while (true) {
-        std::unique_lock lock{mutex_};
-        cv_.wait_for(lock, std::chrono::milliseconds{next_sleep_ms}, [this]() { return stoped_; });
-        if (stoped_) {
-            return;
+        {
+            std::unique_lock lock{mutex_};
+            cv_.wait_for(lock, std::chrono::milliseconds{next_sleep_ms},
+                         [this]() { return stoped_; });
+            if (stoped_) {
+                return;
+            }
         }
         int64_t now = steady_now_ms();
         if (now - last_check_time > kOneMinute) {
@@ -170,33 +388,41 @@ void ThreadWatcher::checkLoop() {
             last_check_time = now;
             next_sleep_ms = 700;
         }
-        for (auto& th : threads_) {
-            if (now - th.second.last_active_time > kMaxBlockTimeMS) {
-                if (terminate_callback_) {
-                    std::stringstream ss;
-                    ss << "Thread(" << th.second.name << ':' << th.second.thread_id
-                       << ") inactive for " << now - th.second.last_active_time << "ms";
-                    terminate_callback_(ss.str());
-                }
-                if (enable_crash_) {
-                    // std::terminate();
-                    crash_me();
-                }
+        // 扫描不加锁，只有发现超时才加锁取线程名
+        for (size_t i = 0; i < kMaxThreads; i++) {
+            const auto& heartbeat = heartbeats_[i];
+            if (!heartbeat.in_use.load(std::memory_order_acquire)) {
+                continue;
+            }
+            const int64_t inactive = now - heartbeat.last_active_ms.load(std::memory_order_relaxed);
+            if (inactive <= kMaxBlockTimeMS) {
+                continue;
+            }
+            std::unique_lock lock{mutex_};
+            if (!heartbeat.in_use.load(std::memory_order_relaxed)) {
+                // 刚刚注销
+                continue;
+            }
+            if (terminate_callback_) {
+                std::stringstream ss;
+                ss << "Thread(" << infos_[i].name << ':' << infos_[i].thread_id
+                   << ") inactive for " << inactive << "ms";
+                auto callback = terminate_callback_;
+                lock.unlock();
+                callback(ss.str());
+            }
+            if (enable_crash_) {
+                // std::terminate();
+                crash_me();
             }
         }
     }
 }
 
-void ThreadWatcher::reportAlive(const std::string& name) {
-    std::lock_guard lock{mutex_};
-    auto iter = threads_.find(name);
-    if (iter != threads_.end()) {
-        iter->second.last_active_time = ltlib::steady_now_ms();
-    }
-}
-
-BlockingThread::BlockingThread(const std::string& prefix, const EntryFunction& func)
+BlockingThread::BlockingThread(const std::string& prefix, const EntryFunction& func,
+                               const ThreadOptions& options)
     : user_func_{func}
+    , options_{options}
     , last_report_time_{ltlib::steady_now_ms()} {
     std::stringstream ss;
     ss << prefix << '-' << std::hex << (int64_t)this;
@@ -210,11 +436,12 @@ BlockingThread::~BlockingThread() {
 }
 
 std::unique_ptr<BlockingThread> BlockingThread::create(const std::string& prefix,
-                                                       const EntryFunction& func) {
+                                                       const EntryFunction& func,
+                                                       const ThreadOptions& options) {
     if (prefix.empty() || func == nullptr) {
         return nullptr;
     }
-    std::unique_ptr<BlockingThread> bthread{new BlockingThread{prefix, func}};
+    std::unique_ptr<BlockingThread> bthread{new BlockingThread{prefix, func, options}};
     bthread->start();
     return bthread;
 }
@@ -232,6 +459,7 @@ void BlockingThread::start() {
 
 void BlockingThread::main_loop(std::promise<void>& promise) {
     set_thread_name();
+    apply_thread_options(options_);
     register_to_thread_watcher();
     promise.set_value();
     user_func_(std::bind(&BlockingThread::i_am_alive, this));
@@ -240,78 +468,69 @@ void BlockingThread::main_loop(std::promise<void>& promise) {
 }
 
 void BlockingThread::register_to_thread_watcher() {
-    ThreadWatcher::instance()->add(name_, std::this_thread::get_id());
+    watch_slot_ = ThreadWatcher::instance()->add(name_, std::this_thread::get_id());
 }
 
 void BlockingThread::unregister_from_thread_watcher() {
-    ThreadWatcher::instance()->remove(name_);
+    ThreadWatcher::instance()->remove(watch_slot_);
 }
 
 void BlockingThread::i_am_alive() {
-    constexpr int64_t k1Second = 1'000;
     int64_t now = ltlib::steady_now_ms();
-    if (now - last_report_time_ > k1Second) {
+    if (now - last_report_time_ >= ThreadWatcher::kReportIntervalMS) {
         last_report_time_ = now;
-        ThreadWatcher::instance()->reportAlive(name_);
+        ThreadWatcher::instance()->reportAlive(watch_slot_, now);
     }
 }
 
 void BlockingThread::set_thread_name() {
     ::set_current_thread_name(name_.c_str());
+    Tracer::set_thread_name(name_);
 }
 
-std::unique_ptr<TaskThread> TaskThread::create(const std::string& prefix) {
+std::unique_ptr<TaskThread> TaskThread::create(const std::string& prefix,
+                                               const ThreadOptions& options) {
     if (prefix.empty()) {
         return nullptr;
     }
-    std::unique_ptr<TaskThread> tthread{new TaskThread{prefix}};
+    std::unique_ptr<TaskThread> tthread{new TaskThread{prefix, options}};
     tthread->start();
     return tthread;
 }
 
-TaskThread::TaskThread(const std::string& prefix)
-    : last_report_time_{ltlib::steady_now_ms()} {
+TaskThread::TaskThread(const std::string& prefix, const ThreadOptions& options)
+    : options_{options}
+    , delay_tasks_{Timestamp::now().microseconds()}
+    , last_report_time_{ltlib::steady_now_ms()} {
     std::stringstream ss;
     ss << prefix << '-' << std::hex << (int64_t)this;
     name_ = ss.str();
 }
 
 TaskThread::~TaskThread() {
-    {
-        std::lock_guard lock{mutex_};
-        stoped_ = true;
-    }
-    cv_.notify_one();
+    stoped_.store(true, std::memory_order_release);
+    event_.notify();
     // task thread可能没有start()就析构了，所以需要检查joinable()
     if (thread_.joinable()) {
         thread_.join();
     }
 }
 
-void TaskThread::post(const Task& task) {
-    {
-        std::lock_guard<std::mutex> lock{mutex_};
-        tasks_.push_back(task);
-        wakeup_ = true;
-    }
-    cv_.notify_one();
+void TaskThread::post(Task task, const Location& from) {
+    tasks_.push(std::move(task), TaskQueue::Meta{Timestamp::now().microseconds(), from});
+    event_.notify();
 }
 
-TaskThread::TimerID TaskThread::post_delay(TimeDelta delta_time, const Task& task) {
-    Timestamp when = Timestamp::now() + delta_time;
+TaskThread::TimerID TaskThread::post_delay(TimeDelta delta_time, Task task, const Location& from) {
+    const int64_t when = Timestamp::now().microseconds() + delta_time.value();
+    TimerID timer;
     {
         std::lock_guard<std::mutex> lock{mutex_};
-        for (;;) {
-            auto iter = delay_tasks_.find(when);
-            if (iter == delay_tasks_.end()) {
-                delay_tasks_.emplace(when, task);
-                break;
-            }
-            when = when + 1_us;
-        }
+        timer = delay_tasks_.add(when, std::move(task), from);
     }
-    cv_.notify_one();
-    return when.microseconds();
+    // 新定时器可能比线程正在等的那个更早到期，要让它重新计算睡眠时间
+    wake_up();
+    return timer;
 }
 
 void TaskThread::start() {
@@ -323,88 +542,106 @@ void TaskThread::start() {
 
 void TaskThread::main_loop(std::promise<void>& promise) {
     set_thread_name();
+    apply_thread_options(options_);
     register_to_thread_watcher();
     promise.set_value();
 
-    while (!stoped_) {
+    while (!stoped_.load(std::memory_order_acquire)) {
         i_am_alive();
-        auto old_tasks = get_pending_tasks();
-        auto [delay_tasks, sleep_for] = get_timeup_delay_tasks();
-        // auto proactor_tasks = get_proactor_tasks();
-
-        if (old_tasks.empty() && delay_tasks.empty()) { // && proactor_tasks.empty())
-            std::unique_lock lock{mutex_};
-            wakeup_.store(false, std::memory_order_relaxed);
-            cv_.wait_for(lock, std::chrono::microseconds{sleep_for.value()}, [this]() {
-                return wakeup_.load(std::memory_order_relaxed);
-            });
+        auto [delay_count, sleep_for] = run_timeup_delay_tasks();
+        size_t task_count = run_pending_tasks();
+        if (delay_count != 0 || task_count != 0) {
             continue;
         }
-
-        for (auto&& task : delay_tasks) {
-            task();
-        }
-        for (auto&& task : old_tasks) {
-            task();
+        // 登记等待之后再检查一遍，和post()/wake_up()里的notify()配对，不会漏掉唤醒
+        auto key = event_.prepare_wait();
+        if (!tasks_.empty() || stoped_.load(std::memory_order_acquire) ||
+            wakeup_.exchange(false, std::memory_order_acq_rel) || sleep_for.value() <= 0) {
+            event_.cancel_wait();
+            continue;
         }
-        // for (auto&& task : proactor_tasks) {
-        //     task();
-        // }
+        sleeping_.store(true, std::memory_order_relaxed);
+        event_.wait_for(key, std::chrono::microseconds{sleep_for.value()});
+        sleeping_.store(false, std::memory_order_relaxed);
     }
     unregister_from_thread_watcher();
     LOG(INFO) << "TaskThread '" << name_.c_str() << "' exit main loop";
 }
 
 void TaskThread::wake_up() {
-    {
-        std::lock_guard lock{mutex_};
-        wakeup_ = true;
-    }
-    cv_.notify_one();
+    wakeup_.store(true, std::memory_order_release);
+    event_.notify();
 }
 
 void TaskThread::i_am_alive() {
-    constexpr int64_t k1Second = 1'000;
     int64_t now = ltlib::steady_now_ms();
-    if (now - last_report_time_ > k1Second) {
+    if (now - last_report_time_ >= ThreadWatcher::kReportIntervalMS) {
         last_report_time_ = now;
-        ThreadWatcher::instance()->reportAlive(name_);
+        ThreadWatcher::instance()->reportAlive(watch_slot_, now);
     }
 }
 
 void TaskThread::register_to_thread_watcher() {
-    ThreadWatcher::instance()->add(name_, std::this_thread::get_id());
+    watch_slot_ = ThreadWatcher::instance()->add(name_, std::this_thread::get_id());
 }
 
 void TaskThread::unregister_from_thread_watcher() {
-    ThreadWatcher::instance()->remove(name_);
+    ThreadWatcher::instance()->remove(watch_slot_);
 }
 
 void TaskThread::set_thread_name() {
     ::set_current_thread_name(name_.c_str());
-}
-
-std::deque<TaskThread::Task> TaskThread::get_pending_tasks() {
-    std::lock_guard lock{mutex_};
-    return std::move(tasks_);
-}
-
-std::tuple<std::vector<TaskThread::Task>, TimeDelta> TaskThread::get_timeup_delay_tasks() {
-    std::vector<Task> tasks;
-    auto now = Timestamp::now();
-    std::lock_guard lock{mutex_};
-    auto iter = delay_tasks_.begin();
-    while (iter != delay_tasks_.end() && iter->first <= now) {
-        tasks.push_back(iter->second);
-        iter = delay_tasks_.erase(iter);
+    Tracer::set_thread_name(name_);
+}
+
+size_t TaskThread::run_pending_tasks() {
+    // 一轮最多执行这么多，不停给自己投递任务的线程也能按时处理定时器和退出
+    constexpr size_t kMaxTasksPerRound = 256;
+    size_t count = 0;
+    Task task;
+    TaskQueue::Meta meta;
+    while (count < kMaxTasksPerRound && tasks_.pop(task, meta)) {
+        const int64_t start = Timestamp::now().microseconds();
+        {
+            LT_TRACE_SCOPE("task");
+            task();
+        }
+        task = nullptr;
+        const int64_t end = Timestamp::now().microseconds();
+        metrics_.record(meta.from, start - meta.enqueue_us, end - start);
+        count++;
     }
+    if (count == 0 && !tasks_.empty()) {
+        // 有生产者正在push()，让出CPU等它完成
+        std::this_thread::yield();
+    }
+    return count;
+}
 
-    if (!delay_tasks_.empty()) {
-        return {tasks, delay_tasks_.begin()->first - now};
+std::tuple<size_t, TimeDelta> TaskThread::run_timeup_delay_tasks() {
+    const int64_t now = Timestamp::now().microseconds();
+    TimeDelta sleep_for{10'000};
+    {
+        std::lock_guard lock{mutex_};
+        delay_tasks_.advance(now, expired_tasks_);
+        auto next = delay_tasks_.next_wakeup_us();
+        if (next.has_value()) {
+            sleep_for = TimeDelta{std::max<int64_t>(*next - now, 0)};
+        }
     }
-    else {
-        return {tasks, TimeDelta{10'000}};
+    // 在锁外执行，任务里可以再post_delay()或cancel()
+    for (auto& timer : expired_tasks_) {
+        const int64_t start = Timestamp::now().microseconds();
+        {
+            LT_TRACE_SCOPE("delay_task");
+            timer.task();
+        }
+        const int64_t end = Timestamp::now().microseconds();
+        metrics_.record_delayed(timer.from, start - timer.when_us, end - start);
     }
+    const size_t count = expired_tasks_.size();
+    expired_tasks_.clear();
+    return {count, sleep_for};
 }
 
 bool TaskThread::is_current_thread() {
@@ -416,12 +653,13 @@ void TaskThread::wake() {
 }
 
 bool TaskThread::is_running() {
-    return wakeup_.load(std::memory_order_relaxed);
+    return !sleeping_.load(std::memory_order_relaxed);
 }
 
-void TaskThread::invokeInternal(const Task& task) {
+void TaskThread::invokeInternal(Task task) {
     std::promise<void> promise;
-    post([&promise, task]() {
+    // 调用者会一直等到任务执行完，按引用捕获是安全的
+    post([&promise, &task]() {
         task();
         promise.set_value();
     });
@@ -430,7 +668,343 @@ void TaskThread::invokeInternal(const Task& task) {
 
 void TaskThread::cancel(TimerID timer) {
     std::lock_guard<std::mutex> lock(mutex_);
-    delay_tasks_.erase(timer);
+    delay_tasks_.cancel(timer);
+}
+
+struct Executor::Worker
+{
+    std::string name;
+    // TaskQueue只允许一个消费者，谁抢到这个标记谁才能pop()，偷任务也一样
+    std::atomic<bool> consuming { false };
+    TaskQueue tasks;
+    std::vector<TimingWheel::Expired> expired_tasks;
+    ThreadWatcher::SlotID watch_slot = ThreadWatcher::kInvalidSlot;
+    int64_t last_report_time = 0;
+    std::thread thread;
+};
+
+Executor* Executor::shared() {
+    static Executor* const executor = []() {
+        auto exec = new Executor{"executor", 0, ThreadOptions{}};
+        exec->start();
+        return exec;
+    }();
+    return executor;
+}
+
+std::unique_ptr<Executor> Executor::create(const std::string& prefix, size_t num_threads,
+                                           const ThreadOptions& options) {
+    if (prefix.empty()) {
+        return nullptr;
+    }
+    std::unique_ptr<Executor> executor{new Executor{prefix, num_threads, options}};
+    executor->start();
+    return executor;
+}
+
+Executor::Executor(const std::string& prefix, size_t num_threads, const ThreadOptions& options)
+    : prefix_{prefix}
+    , options_{options}
+    , delay_tasks_{Timestamp::now().microseconds()} {
+    if (num_threads == 0) {
+        num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+    }
+    for (size_t i = 0; i < num_threads; i++) {
+        auto worker = std::make_unique<Worker>();
+        std::stringstream ss;
+        ss << prefix << '-' << i << '-' << std::hex << (int64_t)this;
+        worker->name = ss.str();
+        worker->last_report_time = ltlib::steady_now_ms();
+        workers_.push_back(std::move(worker));
+    }
+}
+
+Executor::~Executor() {
+    stoped_.store(true, std::memory_order_release);
+    event_.notify();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void Executor::start() {
+    for (size_t i = 0; i < workers_.size(); i++) {
+        std::promise<void> promise;
+        auto future = promise.get_future();
+        workers_[i]->thread = std::thread{[&promise, i, this]() { main_loop(i, promise); }};
+        future.get();
+    }
+}
+
+void Executor::post(Task task) {
+    size_t index;
+    if (g_current_executor == this) {
+        index = g_current_worker;
+    }
+    else {
+        index = next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    }
+    workers_[index]->tasks.push(std::move(task));
+    pending_.fetch_add(1, std::memory_order_release);
+    event_.notify_one();
+}
+
+Executor::TimerID Executor::post_delay(TimeDelta delta_time, Task task) {
+    return post_delay(delta_time, std::move(task), Location{}, nullptr, nullptr);
+}
+
+Executor::TimerID Executor::post_delay(TimeDelta delta_time, Task task, const Location& from,
+                                       TimingWheel::Dispatch dispatch,
+                                       std::shared_ptr<void> target) {
+    const int64_t when = Timestamp::now().microseconds() + delta_time.value();
+    TimerID timer;
+    {
+        std::lock_guard<std::mutex> lock{timer_mutex_};
+        timer = delay_tasks_.add(when, std::move(task), from, dispatch, std::move(target));
+    }
+    const int64_t deadline = timer_deadline_us_.load(std::memory_order_acquire);
+    if (deadline == 0 || when < deadline) {
+        // 没有线程在等定时器，或者新定时器比它等的那个更早
+        event_.notify();
+    }
+    return timer;
+}
+
+void Executor::cancel(TimerID timer) {
+    std::lock_guard<std::mutex> lock{timer_mutex_};
+    delay_tasks_.cancel(timer);
+}
+
+bool Executor::is_current_thread() const {
+    return g_current_executor == this;
+}
+
+void Executor::main_loop(size_t index, std::promise<void>& promise) {
+    // 不负责等定时器的空闲线程睡这么久，够ThreadWatcher判断它还活着
+    constexpr int64_t kIdleWaitUs = 500'000;
+    Worker* worker = workers_[index].get();
+    ::set_current_thread_name(worker->name.c_str());
+    Tracer::set_thread_name(worker->name);
+    apply_thread_options(options_);
+    g_current_executor = this;
+    g_current_worker = index;
+    worker->watch_slot = ThreadWatcher::instance()->add(worker->name, std::this_thread::get_id());
+    promise.set_value();
+
+    while (!stoped_.load(std::memory_order_acquire)) {
+        i_am_alive(worker);
+        const size_t delay_count = run_timeup_delay_tasks(worker);
+        if (run_one() || delay_count != 0) {
+            continue;
+        }
+        if (pending_.load(std::memory_order_acquire) > 0) {
+            // 有生产者正在push()，或者别的线程正占着队列
+            std::this_thread::yield();
+            continue;
+        }
+        // 登记等待之后再检查一遍，和post()/post_delay()里的notify配对，不会漏掉唤醒
+        auto key = event_.prepare_wait();
+        const int64_t now = Timestamp::now().microseconds();
+        const int64_t next_timer = next_timer_us();
+        if (pending_.load(std::memory_order_acquire) > 0 ||
+            stoped_.load(std::memory_order_acquire) || next_timer <= now) {
+            event_.cancel_wait();
+            continue;
+        }
+        int64_t wakeup = std::min(next_timer, now + kIdleWaitUs);
+        int64_t no_waiter = 0;
+        const bool timer_waiter =
+            timer_deadline_us_.compare_exchange_strong(no_waiter, wakeup, std::memory_order_acq_rel);
+        if (!timer_waiter) {
+            wakeup = now + kIdleWaitUs;
+        }
+        const bool notified = event_.wait_for(key, std::chrono::microseconds{wakeup - now});
+        if (timer_waiter) {
+            timer_deadline_us_.store(0, std::memory_order_release);
+            // 被新任务叫醒，接下来可能要执行很久，把等定时器的活交给另一个空闲线程
+            if (notified) {
+                event_.notify_one();
+            }
+        }
+    }
+    ThreadWatcher::instance()->remove(worker->watch_slot);
+    g_current_executor = nullptr;
+    LOG(INFO) << "Executor worker '" << worker->name.c_str() << "' exit main loop";
+}
+
+bool Executor::run_one() {
+    if (pending_.load(std::memory_order_acquire) <= 0) {
+        return false;
+    }
+    // 先取自己队列里的，再从下一个线程开始依次偷
+    const size_t count = workers_.size();
+    for (size_t i = 0; i < count; i++) {
+        if (try_run(workers_[(g_current_worker + i) % count].get())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Executor::try_run(Worker* victim) {
+    if (victim->consuming.exchange(true, std::memory_order_acquire)) {
+        return false;
+    }
+    Task task;
+    const bool got = victim->tasks.pop(task);
+    victim->consuming.store(false, std::memory_order_release);
+    if (!got) {
+        return false;
+    }
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    LT_TRACE_SCOPE("task");
+    task();
+    return true;
+}
+
+size_t Executor::run_timeup_delay_tasks(Worker* worker) {
+    {
+        // 别的线程正在处理定时器，这一轮不用管
+        std::unique_lock<std::mutex> lock{timer_mutex_, std::try_to_lock};
+        if (!lock.owns_lock()) {
+            return 0;
+        }
+        delay_tasks_.advance(Timestamp::now().microseconds(), worker->expired_tasks);
+    }
+    for (auto& timer : worker->expired_tasks) {
+        if (timer.dispatch != nullptr) {
+            timer.dispatch(timer.target, std::move(timer.task), timer.when_us, timer.from);
+            continue;
+        }
+        LT_TRACE_SCOPE("delay_task");
+        timer.task();
+    }
+    const size_t count = worker->expired_tasks.size();
+    worker->expired_tasks.clear();
+    return count;
+}
+
+int64_t Executor::next_timer_us() {
+    std::lock_guard<std::mutex> lock{timer_mutex_};
+    return delay_tasks_.next_wakeup_us().value_or(INT64_MAX);
+}
+
+void Executor::i_am_alive(Worker* worker) {
+    int64_t now = ltlib::steady_now_ms();
+    if (now - worker->last_report_time >= ThreadWatcher::kReportIntervalMS) {
+        worker->last_report_time = now;
+        ThreadWatcher::instance()->reportAlive(worker->watch_slot, now);
+    }
+}
+
+struct Strand::State
+{
+    Executor* executor = nullptr;
+    std::string name;
+    TaskQueue tasks;
+    // 已投递还没执行的任务数. 让它从0变成1的那次post()负责把Strand排进Executor
+    std::atomic<uint32_t> pending { 0 };
+    std::atomic<bool> stoped { false };
+    // 执行一批任务时持有，析构时用来等正在执行的任务
+    std::mutex running;
+    TaskMetrics metrics;
+};
+
+std::unique_ptr<Strand> Strand::create(Executor* executor, const std::string& name) {
+    if (executor == nullptr || name.empty()) {
+        return nullptr;
+    }
+    return std::unique_ptr<Strand>{new Strand{executor, name}};
+}
+
+Strand::Strand(Executor* executor, const std::string& name)
+    : state_{std::make_shared<State>()} {
+    state_->executor = executor;
+    state_->name = name;
+}
+
+Strand::~Strand() {
+    state_->stoped.store(true, std::memory_order_release);
+    // 在自己的任务里析构时，正在执行的就是当前任务，不能等
+    if (!is_current_thread()) {
+        std::lock_guard<std::mutex> lock{state_->running};
+    }
+    LOG(INFO) << "Strand '" << state_->name.c_str() << "' stopped";
+}
+
+void Strand::post(Task task, const Location& from) {
+    post(state_, std::move(task), TaskQueue::Meta{Timestamp::now().microseconds(), from});
+}
+
+Strand::TimerID Strand::post_delay(TimeDelta delta_time, Task task, const Location& from) {
+    // 到期后再转投到Strand，排队时间从预定的到期时间算起，就是迟到的时间
+    return state_->executor->post_delay(delta_time, std::move(task), from, &Strand::post_expired,
+                                        state_);
+}
+
+void Strand::post_expired(const std::shared_ptr<void>& target, Task task, int64_t when_us,
+                          const Location& from) {
+    post(std::static_pointer_cast<State>(target), std::move(task),
+         TaskQueue::Meta{when_us, from, true});
+}
+
+void Strand::cancel(TimerID timer) {
+    state_->executor->cancel(timer);
+}
+
+bool Strand::is_current_thread() const {
+    return g_current_strand == state_.get();
+}
+
+TaskMetrics& Strand::metrics() {
+    return state_->metrics;
+}
+
+void Strand::post(const std::shared_ptr<State>& state, Task task, const TaskQueue::Meta& meta) {
+    state->tasks.push(std::move(task), meta);
+    if (state->pending.fetch_add(1, std::memory_order_acq_rel) == 0) {
+        state->executor->post([state]() { run(state); });
+    }
+}
+
+void Strand::run(const std::shared_ptr<State>& state) {
+    // 一次最多执行这么多，然后重新排队，不让一个忙碌的Strand一直占着工作线程
+    constexpr uint32_t kMaxTasksPerRun = 64;
+    {
+        std::lock_guard<std::mutex> lock{state->running};
+        g_current_strand = state.get();
+        Task task;
+        TaskQueue::Meta meta;
+        for (uint32_t count = 0; count < kMaxTasksPerRun; count++) {
+            // pending不为0说明任务一定会出现在队列里，取不到只是生产者还没push()完
+            while (!state->tasks.pop(task, meta)) {
+                std::this_thread::yield();
+            }
+            if (!state->stoped.load(std::memory_order_acquire)) {
+                const int64_t start = Timestamp::now().microseconds();
+                {
+                    LT_TRACE_SCOPE("strand_task");
+                    task();
+                }
+                const int64_t end = Timestamp::now().microseconds();
+                if (meta.delayed) {
+                    state->metrics.record_delayed(meta.from, start - meta.enqueue_us, end - start);
+                }
+                else {
+                    state->metrics.record(meta.from, start - meta.enqueue_us, end - start);
+                }
+            }
+            task = nullptr;
+            if (state->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                g_current_strand = nullptr;
+                return;
+            }
+        }
+        g_current_strand = nullptr;
+    }
+    state->executor->post([state]() { run(state); });
 }
 
-} // namespace ltlib
\ No newline at end of file
+} // namespace ltlib
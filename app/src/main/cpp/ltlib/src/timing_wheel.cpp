@@ -0,0 +1,252 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ltlib/timing_wheel.h>
+
+#include <algorithm>
+#include <limits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+int countTrailingZeros(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+uint64_t rotateRight(uint64_t value, uint32_t shift) {
+    shift &= 63;
+    return shift == 0 ? value : (value >> shift) | (value << (64 - shift));
+}
+
+} // namespace
+
+namespace ltlib {
+
+TimingWheel::TimingWheel(int64_t now_us)
+    : current_tick_{now_us / kTickUs} {}
+
+TimingWheel::TimerID TimingWheel::add(int64_t when_us, Task task, const Location& from,
+                                      Dispatch dispatch, std::shared_ptr<void> target) {
+    uint32_t index;
+    if (free_head_ != kNil) {
+        index = free_head_;
+        free_head_ = nodes_[index].next;
+    }
+    else {
+        index = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+    Node& node = nodes_[index];
+    node.task = std::move(task);
+    node.when_us = when_us;
+    node.from = from;
+    node.dispatch = dispatch;
+    node.target = std::move(target);
+    node.expiry_tick = (when_us + kTickUs - 1) / kTickUs;
+    place(index);
+    size_++;
+    return static_cast<TimerID>((static_cast<uint64_t>(node.generation) << 32) | index);
+}
+
+bool TimingWheel::cancel(TimerID id) {
+    const auto index = static_cast<uint32_t>(static_cast<uint64_t>(id) & 0xFFFF'FFFF);
+    const auto generation = static_cast<uint32_t>(static_cast<uint64_t>(id) >> 32);
+    if (index >= nodes_.size()) {
+        return false;
+    }
+    Node& node = nodes_[index];
+    if (node.generation != generation || node.list == kNil) {
+        return false;
+    }
+    unlink(index);
+    release(index);
+    size_--;
+    return true;
+}
+
+void TimingWheel::advance(int64_t now_us, std::vector<Expired>& expired) {
+    const int64_t now_tick = now_us / kTickUs;
+    fire(kReadyList, expired);
+    while (current_tick_ < now_tick) {
+        // 中间没有槽需要处理的tick直接跳过，长时间没调用advance()也不会逐个tick空转
+        const int64_t next = next_event_tick();
+        if (next > now_tick) {
+            current_tick_ = now_tick;
+            break;
+        }
+        current_tick_ = next;
+        // 先高层后低层，高层降下来的定时器可能正好落在低层当前要处理的槽里
+        for (int level = kLevels - 1; level > 0; level--) {
+            const int64_t mask = (int64_t{1} << (kSlotBits * level)) - 1;
+            if ((current_tick_ & mask) == 0) {
+                cascade(level);
+            }
+        }
+        fire(static_cast<uint32_t>(current_tick_ & kSlotMask), expired);
+        fire(kReadyList, expired);
+    }
+}
+
+std::optional<int64_t> TimingWheel::next_wakeup_us() const {
+    if (size_ == 0) {
+        return std::nullopt;
+    }
+    if (lists_[kReadyList].head != kNil) {
+        return current_tick_ * kTickUs;
+    }
+    return next_event_tick() * kTickUs;
+}
+
+void TimingWheel::place(uint32_t index) {
+    Node& node = nodes_[index];
+    const int64_t delta = node.expiry_tick - current_tick_;
+    if (delta <= 0) {
+        link(kReadyList, index);
+        return;
+    }
+    for (int level = 0; level < kLevels; level++) {
+        const int shift = kSlotBits * level;
+        if (delta < (int64_t{1} << (shift + kSlotBits))) {
+            const auto slot = static_cast<uint32_t>((node.expiry_tick >> shift) & kSlotMask);
+            link(level * kSlots + slot, index);
+            return;
+        }
+    }
+    // 超出时间轮的范围，挂到最高层最远的槽，转到那里时会按剩余时间重新分配
+    constexpr int kTopShift = kSlotBits * (kLevels - 1);
+    const auto slot = static_cast<uint32_t>(((current_tick_ >> kTopShift) + kSlotMask) & kSlotMask);
+    link((kLevels - 1) * kSlots + slot, index);
+}
+
+void TimingWheel::link(uint32_t list, uint32_t index) {
+    Node& node = nodes_[index];
+    List& l = lists_[list];
+    node.list = list;
+    node.prev = l.tail;
+    node.next = kNil;
+    if (l.tail == kNil) {
+        l.head = index;
+    }
+    else {
+        nodes_[l.tail].next = index;
+    }
+    l.tail = index;
+    if (list != kReadyList) {
+        occupied_[list / kSlots] |= uint64_t{1} << (list % kSlots);
+    }
+}
+
+void TimingWheel::unlink(uint32_t index) {
+    Node& node = nodes_[index];
+    List& l = lists_[node.list];
+    if (node.prev == kNil) {
+        l.head = node.next;
+    }
+    else {
+        nodes_[node.prev].next = node.next;
+    }
+    if (node.next == kNil) {
+        l.tail = node.prev;
+    }
+    else {
+        nodes_[node.next].prev = node.prev;
+    }
+    if (l.head == kNil && node.list != kReadyList) {
+        occupied_[node.list / kSlots] &= ~(uint64_t{1} << (node.list % kSlots));
+    }
+    node.list = kNil;
+    node.prev = kNil;
+    node.next = kNil;
+}
+
+void TimingWheel::release(uint32_t index) {
+    Node& node = nodes_[index];
+    node.task = nullptr;
+    node.dispatch = nullptr;
+    node.target = nullptr;
+    if (++node.generation == 0) {
+        node.generation = 1;
+    }
+    node.next = free_head_;
+    free_head_ = index;
+}
+
+void TimingWheel::cascade(int level) {
+    const int shift = kSlotBits * level;
+    const auto slot = static_cast<uint32_t>((current_tick_ >> shift) & kSlotMask);
+    List& l = lists_[level * kSlots + slot];
+    // 重新分配时只会落到更低层、就绪链表，或者(超远的定时器)最高层的另一个槽，不会回到这条链表
+    while (l.head != kNil) {
+        const uint32_t index = l.head;
+        unlink(index);
+        place(index);
+    }
+}
+
+void TimingWheel::fire(uint32_t list, std::vector<Expired>& expired) {
+    List& l = lists_[list];
+    while (l.head != kNil) {
+        const uint32_t index = l.head;
+        unlink(index);
+        Node& node = nodes_[index];
+        expired.push_back(Expired{std::move(node.task), node.when_us, node.from, node.dispatch,
+                                  std::move(node.target)});
+        release(index);
+        size_--;
+    }
+}
+
+int64_t TimingWheel::next_event_tick() const {
+    int64_t next = std::numeric_limits<int64_t>::max();
+    for (int level = 0; level < kLevels; level++) {
+        if (occupied_[level] == 0) {
+            continue;
+        }
+        // 从当前槽的下一个开始找第一个非空的槽，转一整圈回到当前槽也算
+        const int shift = kSlotBits * level;
+        const int64_t current = current_tick_ >> shift;
+        const uint64_t rotated =
+            rotateRight(occupied_[level], static_cast<uint32_t>((current + 1) & kSlotMask));
+        const int64_t distance = countTrailingZeros(rotated) + 1;
+        next = std::min(next, (current + distance) << shift);
+    }
+    return next;
+}
+
+} // namespace ltlib
@@ -0,0 +1,280 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023 Zhennan Tu <zhennan.tu@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ltlib/trace.h>
+
+#if defined(LT_LINUX) || defined(LT_ANDROID)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <array>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#include <ltlib/logging.h>
+#include <ltlib/times.h>
+
+namespace {
+
+int64_t current_thread_id() {
+#if defined(LT_LINUX) || defined(LT_ANDROID)
+    return static_cast<int64_t>(syscall(SYS_gettid));
+#else
+    return static_cast<int64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+#endif
+}
+
+void write_json_string(std::ostream& out, const char* str) {
+    out << '"';
+    for (const char* p = str; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            out << '\\' << *p;
+        }
+        else if (static_cast<unsigned char>(*p) >= 0x20) {
+            out << *p;
+        }
+    }
+    out << '"';
+}
+
+thread_local std::string t_thread_name;
+
+} // namespace
+
+namespace ltlib {
+
+struct Tracer::ThreadBuffer {
+    struct Event {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<int64_t> timestamp{0};
+        std::atomic<int64_t> arg{0};
+        std::atomic<char> phase{0};
+    };
+    // 只有所属线程写，dump()读. 写完一个事件再发布head
+    std::atomic<uint64_t> head{0};
+    std::atomic<bool> in_use{false};
+    // 以下两个受Tracer::mutex_保护
+    int64_t tid = 0;
+    std::string thread_name;
+    std::array<Event, kEventsPerThread> events;
+};
+
+// 线程退出时归还缓冲区
+struct ThreadBufferHolder {
+    Tracer::ThreadBuffer* buffer = nullptr;
+    ~ThreadBufferHolder() {
+        if (buffer != nullptr) {
+            buffer->in_use.store(false, std::memory_order_release);
+        }
+    }
+};
+
+namespace {
+
+thread_local ThreadBufferHolder t_buffer_holder;
+
+} // namespace
+
+Tracer* Tracer::instance() {
+    static Tracer tracer;
+    return &tracer;
+}
+
+void Tracer::enable() {
+    enabled_.store(true, std::memory_order_relaxed);
+    LOG(INFO) << "Tracer enabled";
+}
+
+void Tracer::disable() {
+    enabled_.store(false, std::memory_order_relaxed);
+    LOG(INFO) << "Tracer disabled";
+}
+
+void Tracer::set_thread_name(const std::string& name) {
+    t_thread_name = name;
+    Tracer* tracer = instance();
+    if (t_buffer_holder.buffer != nullptr) {
+        std::lock_guard lock{tracer->mutex_};
+        t_buffer_holder.buffer->thread_name = name;
+    }
+}
+
+Tracer::ThreadBuffer* Tracer::current_buffer(bool create) {
+    if (t_buffer_holder.buffer == nullptr && create) {
+        t_buffer_holder.buffer = acquire_buffer();
+    }
+    return t_buffer_holder.buffer;
+}
+
+Tracer::ThreadBuffer* Tracer::acquire_buffer() {
+    std::lock_guard lock{mutex_};
+    ThreadBuffer* buffer = nullptr;
+    // 缓冲区不多时保留已退出线程的事件，超过上限才复用
+    if (buffers_.size() >= kMaxThreadBuffers) {
+        for (auto& b : buffers_) {
+            if (!b->in_use.load(std::memory_order_acquire)) {
+                buffer = b.get();
+                break;
+            }
+        }
+    }
+    if (buffer == nullptr) {
+        buffers_.push_back(std::make_unique<ThreadBuffer>());
+        buffer = buffers_.back().get();
+    }
+    // 复用时丢掉上一个线程的事件
+    buffer->head.store(0, std::memory_order_release);
+    buffer->in_use.store(true, std::memory_order_relaxed);
+    buffer->tid = current_thread_id();
+    buffer->thread_name = t_thread_name;
+    return buffer;
+}
+
+void Tracer::record(ThreadBuffer* buffer, char phase, const char* name, int64_t arg) {
+    const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    auto& event = buffer->events[head % kEventsPerThread];
+    event.name.store(name, std::memory_order_relaxed);
+    event.timestamp.store(steady_now_us(), std::memory_order_relaxed);
+    event.arg.store(arg, std::memory_order_relaxed);
+    event.phase.store(phase, std::memory_order_relaxed);
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void Tracer::begin(const char* name) {
+    if (is_enabled()) {
+        record(current_buffer(true), 'B', name, 0);
+    }
+}
+
+void Tracer::end(const char* name) {
+    // 开始时记录了begin，中途关闭也要配对
+    ThreadBuffer* buffer = current_buffer(false);
+    if (buffer != nullptr) {
+        record(buffer, 'E', name, 0);
+    }
+}
+
+void Tracer::counter(const char* name, int64_t value) {
+    if (is_enabled()) {
+        record(current_buffer(true), 'C', name, value);
+    }
+}
+
+void Tracer::flow_begin(const char* name, uint64_t id) {
+    if (is_enabled()) {
+        record(current_buffer(true), 's', name, static_cast<int64_t>(id));
+    }
+}
+
+void Tracer::flow_step(const char* name, uint64_t id) {
+    if (is_enabled()) {
+        record(current_buffer(true), 't', name, static_cast<int64_t>(id));
+    }
+}
+
+void Tracer::flow_end(const char* name, uint64_t id) {
+    if (is_enabled()) {
+        record(current_buffer(true), 'f', name, static_cast<int64_t>(id));
+    }
+}
+
+bool Tracer::dump(const std::string& path) {
+    std::ofstream out{path, std::ios::out | std::ios::trunc};
+    if (!out.is_open()) {
+        LOG(ERR) << "Open trace file '" << path << "' failed";
+        return false;
+    }
+    // 正在写的线程可能覆盖最老的几个事件，跳过它们
+    constexpr uint64_t kOverwriteMargin = 64;
+    const int64_t pid = 1;
+    bool first = true;
+    auto separator = [&out, &first]() {
+        out << (first ? "\n" : ",\n");
+        first = false;
+    };
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    std::lock_guard lock{mutex_};
+    for (auto& buffer : buffers_) {
+        const uint64_t head = buffer->head.load(std::memory_order_acquire);
+        if (head == 0) {
+            continue;
+        }
+        if (!buffer->thread_name.empty()) {
+            separator();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+                << ",\"tid\":" << buffer->tid << ",\"args\":{\"name\":";
+            write_json_string(out, buffer->thread_name.c_str());
+            out << "}}";
+        }
+        const uint64_t begin =
+            head > kEventsPerThread ? head - kEventsPerThread + kOverwriteMargin : 0;
+        for (uint64_t i = begin; i < head; i++) {
+            const auto& event = buffer->events[i % kEventsPerThread];
+            const char* name = event.name.load(std::memory_order_relaxed);
+            const char phase = event.phase.load(std::memory_order_relaxed);
+            if (name == nullptr || phase == 0) {
+                continue;
+            }
+            const int64_t arg = event.arg.load(std::memory_order_relaxed);
+            separator();
+            out << "{\"name\":";
+            write_json_string(out, name);
+            out << ",\"ph\":\"" << phase
+                << "\",\"ts\":" << event.timestamp.load(std::memory_order_relaxed)
+                << ",\"pid\":" << pid << ",\"tid\":" << buffer->tid;
+            switch (phase) {
+            case 'C':
+                out << ",\"args\":{\"value\":" << arg << "}";
+                break;
+            case 's':
+            case 't':
+            case 'f':
+                // flow事件绑定到所在的slice上
+                out << ",\"cat\":\"flow\",\"id\":" << arg << ",\"bp\":\"e\"";
+                break;
+            default:
+                break;
+            }
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    out.close();
+    if (!out) {
+        LOG(ERR) << "Write trace file '" << path << "' failed";
+        return false;
+    }
+    LOG(INFO) << "Trace dumped to " << path;
+    return true;
+}
+
+} // namespace ltlib
@@ -273,6 +273,14 @@ class MainActivity : ComponentActivity() {
             bundle.putInt("audioChannels", msg.streamingParams.audioChannels)
             bundle.putInt("audioFreq", msg.streamingParams.audioSampleRate)
             bundle.putStringArrayList("reflexServers", reflxs)
+            // 调试开关，暂时没有界面，用adb改lanthing_kv_settings
+            bundle.putBoolean("asyncDecode", settings?.getBoolean("async_decode", false) ?: false)
+            bundle.putBoolean("smoothPlayback", settings?.getBoolean("smooth_playback", false) ?: false)
+            if (settings?.getBoolean("record_stream", false) == true) {
+                // 录制文件可以adb pull出来，也可以用LtClient.replayStream()在手机上回放
+                val dir = getExternalFilesDir(null) ?: filesDir
+                bundle.putString("recordPath", "${dir.path}/stream_${System.currentTimeMillis()}.lrec")
+            }
             val intent = Intent(this@MainActivity, StreamActivity::class.java)
             intent.putExtras(bundle)
             activity.startActivity(intent)
@@ -31,6 +31,9 @@ class StreamActivity : ComponentActivity() {
     private var audioChannels: Int = 0
     private var audioFreq: Int = 0
     private var reflexServers: ArrayList<String>? = null
+    private var asyncDecode: Boolean = false
+    private var smoothPlayback: Boolean = false
+    private var recordPath: String = ""
     private lateinit var ltClient: LtClient
     override fun onCreate(savedInstanceState: Bundle?) {
         super.onCreate(savedInstanceState)
@@ -53,6 +56,9 @@ class StreamActivity : ComponentActivity() {
             audioChannels = params.getInt("audioChannels", 0)
             audioFreq = params.getInt("audioFreq", 0)
             reflexServers = params.getStringArrayList("reflexServers")
+            asyncDecode = params.getBoolean("asyncDecode", false)
+            smoothPlayback = params.getBoolean("smoothPlayback", false)
+            recordPath = params.getString("recordPath", "")
             if (clientID.isEmpty() || roomID.isEmpty() || token.isEmpty() || p2pUsername.isEmpty()
                 || p2pPassword.isEmpty() || signalingAddress.isEmpty() || signalingPort == 0
                 || (codecType != "avc" && codecType != "hevc") || audioChannels == 0
@@ -149,6 +155,9 @@ class StreamActivity : ComponentActivity() {
             audioChannels = audioChannels,
             audioFreq = audioFreq,
             reflexServers = rflxs,
+            asyncDecode = asyncDecode,
+            smoothPlayback = smoothPlayback,
+            recordPath = recordPath,
             onMessage = this::onLtClientMessage
         )
         if (!ltClient.ok()) {
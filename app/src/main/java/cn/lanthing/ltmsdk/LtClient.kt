@@ -40,6 +40,12 @@ class LtClient(
     private val audioChannels: Int,
     private val audioFreq: Int,
     private val reflexServers: List<String>,
+    // 多帧同时解码(MediaCodec异步模式)，设备不支持时native层自动退回同步解码
+    private val asyncDecode: Boolean = false,
+    // 按采集节奏匀速显示，用自适应的缓冲吸收网络抖动，代价是多一点延迟
+    private val smoothPlayback: Boolean = false,
+    // 非空时把收到的视频流录制到这个文件，用replayStream()回放
+    private val recordPath: String = "",
     private val onMessage: (msgType: UInt, message: Message) -> Unit //对应lanthing-pc ClientManager::onPipeMessage
 ) {
 
@@ -55,7 +61,8 @@ class LtClient(
     init {
         nativeClient = createNativeClient( videoSurface, cursorSurface, videoWidth, videoHeight,
             clientID, roomID, token, p2pUsername, p2pPassword, signalingAddress, signalingPort,
-            codecType, audioChannels, audioFreq, reflexServers
+            codecType, audioChannels, audioFreq, reflexServers, asyncDecode,
+            smoothPlayback, recordPath
         )
     }
 
@@ -78,6 +85,21 @@ class LtClient(
         }
     }
 
+    // 调试用: 回放录制的视频流，代替网络收到的帧. 不要和start()一起用.
+    // maxSpeed为true时不按原来的节奏，尽快送帧，用来测解码渲染的极限吞吐
+    fun replayStream(path: String, maxSpeed: Boolean): Boolean {
+        return nativeReplayStream(nativeClient, path, maxSpeed)
+    }
+
+    // 打开/关闭native层的trace记录, 用chrome://tracing或Perfetto查看dumpTrace()的输出
+    fun setTracing(enable: Boolean) {
+        nativeSetTracing(enable)
+    }
+
+    fun dumpTrace(path: String): Boolean {
+        return nativeDumpTrace(path)
+    }
+
     private fun onSignalingConnected() {
         val msg = JoinRoom.newBuilder()
             .setRoomId(roomID)
@@ -176,10 +198,15 @@ class LtClient(
                                             clientID: String, roomID: String, token: String,
                                             p2pUsername: String, p2pPassword: String, signalingAddress: String,
                                             signalingPort: Int, codecType: String, audioChannels: Int,
-                                            audioFreq: Int, reflexServers: List<String>): Long
+                                            audioFreq: Int, reflexServers: List<String>,
+                                            asyncDecode: Boolean, smoothPlayback: Boolean,
+                                            recordPath: String): Long
     private external fun destroyNativeClient(cli: Long)
     private external fun nativeStart(cli: Long): Boolean
     private external fun nativeStop(cli: Long)
     private external fun nativeSwitchMouseMode(cli: Long)
     private external fun nativeOnSignalingMessage(cli: Long, key: String, value: ByteArray)
+    private external fun nativeReplayStream(cli: Long, path: String, maxSpeed: Boolean): Boolean
+    private external fun nativeSetTracing(enable: Boolean)
+    private external fun nativeDumpTrace(path: String): Boolean
 }
\ No newline at end of file